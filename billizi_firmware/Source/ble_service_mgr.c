@@ -55,6 +55,10 @@ static simpleProfileCBs_t app_comm_profile_cb = {
     user_ble_communication_cb  // Charactersitic value change callback
 };
 
+// BLE 로그 검색 상태
+static log_query_t ble_qry;
+static uint8 ble_qry_ring = LOG_RING_CNT;
+
 /*********************************************************************
  * @fn      peripheralStateNotificationCB
  *
@@ -138,6 +142,8 @@ static void user_ble_communication_cb(uint8 paramID)
 {
     uint8 data_char3[20];
     uint8 data_char1;
+    uint8 *qry_packet;
+    uint8 qry_size;
 
     uint16 command;
 	print_uart("profile changed..2\r\n");
@@ -166,6 +172,22 @@ static void user_ble_communication_cb(uint8 paramID)
                 case 0xFFFF:
                     HAL_SYSTEM_RESET();
                     break;
+                case CMD_LOG_QUERY:
+                    ble_qry_ring = data_char3[2];
+                    log_query_begin(&ble_qry, BUILD_UINT16(data_char3[3], data_char3[4]),
+                                    BUILD_UINT32(data_char3[5], data_char3[6], data_char3[7], data_char3[8]),
+                                    BUILD_UINT32(data_char3[9], data_char3[10], data_char3[11], data_char3[12]));
+                    /* fall through */
+                case CMD_LOG_NEXT:
+                    qry_packet = get_query_packet(ble_qry_ring, &ble_qry, &qry_size);
+                    set_simpleprofile(SIMPLEPROFILE_CHAR3, qry_size, qry_packet);
+                    osal_mem_free(qry_packet);
+                    break;
+                case CMD_BATT_SOC:
+                    qry_packet = get_soc_packet();
+                    set_simpleprofile(SIMPLEPROFILE_CHAR3, BATT_SOC_LEN, qry_packet);
+                    osal_mem_free(qry_packet);
+                    break;
                 default:
                     GAPRole_TerminateConnection();
                     break;
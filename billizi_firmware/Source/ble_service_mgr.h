@@ -51,6 +51,16 @@
 #define CMD_SYS_REBOOT      0xFFFF
 #define CMD_RESET_FLASH     0xA000
 
+/* 로그 검색 (CHAR3 write, 결과 packet은 CHAR3 read)
+ * CMD_LOG_QUERY: [2]ring [3:4]type_mask [5:8]t_from [9:12]t_to (little endian)
+ * CMD_LOG_NEXT: 다음 결과, 검색 종료시 HEADER_QUERY_END 1byte */
+#define CMD_LOG_QUERY       0xE0A0
+#define CMD_LOG_NEXT        0xE1A0
+
+/* 배터리 잔량 (CHAR3 write, HEADER_SOC packet은 CHAR3 read)
+ * [1]soc(%) [2:3]남은 용량(mAh) [4:7]누적 충전량(mAh) [8:11]누적 방전량(mAh) */
+#define CMD_BATT_SOC        0xE2A0
+
 #define APP_FACTORY_INIT     0x01
 #define APP_USER_COMM        0x02
 
@@ -49,11 +49,11 @@ static void current_battery_status_check(Control_flag_t *apst_flag)
     //     apst_flag->abnormal |= ERR_BROKEN_CABLE;
     // }
 
-    if (read_temperature() >= 700) {
+    if (read_temperature() >= TEMP_OVER) {
         apst_flag->abnormal |= ERR_TEMP_OVER;
     }
 
-    if (read_voltage(READ_BATT_SIDE) < MIN_BATT_V) {
+    if (read_voltage(READ_BATT_SIDE) < MIN_BATT_MV) {
         apst_flag->abnormal |= ERR_LOSS_BATTERY;
     }
 }
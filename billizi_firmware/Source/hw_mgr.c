@@ -1,37 +1,95 @@
 #include "hw_mgr.h"
 #include "hal_i2c.h"
 
+static coulomb_cnt_t st_cc;
+static temp_cache_t st_temp;
+static uint8 temp_alert_task = TASK_NO_TASK;
+static uint16 temp_alert_evt;
+static cable_check_t st_cable;
 
-uint8 check_cable_status()
+static int16 calc_i2c_temperature(uint8 * i2c_data);
+
+//휴지 상태 배터리 전압(OCV)[mV], 0%부터 10% 간격
+static const uint16 ocv_table[CC_OCV_POINTS] = {
+    3100, 3550, 3680, 3740, 3780, 3820, 3870, 3930, 4000, 4080, 4200
+};
+
+
+/**
+ * @fn cable_check_finish
+ * @brief 검사 pin을 모두 끄고 결과를 callback으로 전달
+ */
+static void cable_check_finish(uint8 result, uint16 resp_ms)
+{
+    EN_CONN_RETR = 0;
+    RETR_TEST_EN = 0;
+    st_cable.step = CABLE_STEP_IDLE;
+
+    if (st_cable.p_cb) {
+        st_cable.p_cb(result, resp_ms);
+    }
+}
+
+/**
+ * @fn cable_check_start
+ * @brief 빌리지 케이블 검사 시작, pin만 켜고 바로 반환
+ *        이후 PMIC 응답 확인은 task_id의 evt에서 cable_check_service로 진행됨
+ * 
+ * @param task_id, evt: CABLE_POLL_MS마다 받을 task와 event
+ * @param p_cb: 검사 완료시 호출, evt 처리 중 task context에서 불림
+ * @return TRUE: 시작, FALSE: 이미 검사중
+ */
+uint8 cable_check_start(uint8 task_id, uint16 evt, cable_cb_t p_cb)
+{
+    if (st_cable.step != CABLE_STEP_IDLE) {
+        return FALSE;
+    }
+
+    st_cable.task_id = task_id;
+    st_cable.evt = evt;
+    st_cable.p_cb = p_cb;
+    st_cable.start_ms = osal_GetSystemClock();
+    st_cable.step = CABLE_STEP_WAIT;
+
+    //PMIC auto detect enable
+    //NMOS두개를 켜서 10킬로오옴 저항 부하로 PMIC를 깨움
+    EN_CONN_RETR = 1;  // 코넥터 충전 활성화
+    RETR_TEST_EN = 1;  // 빌리지 케이블 단락 검사 활성화
+
+    osal_start_timerEx(task_id, evt, CABLE_POLL_MS);
+
+    return TRUE;
+}
+
+/**
+ * @fn cable_check_service
+ * @brief 검사 event마다 호출, PMIC 응답을 확인하고 응답이 없으면 다시 예약
+ */
+void cable_check_service(void)
 {
-	/*
-	빌리지 케이블 불량 확인
-	return 0 : 정상
-	return 1 : 불량
-	*/
-	//default cable status is normal
-	uint8 cable_status = 0;
+    uint16 elapsed;
 
-	//PMIC auto detect enable
-	//NMOS두개를 켜서 10킬로오옴 저항 부하로 PMIC를 깨움
-	EN_CONN_RETR = 1;  // 코넥터 충전 활성화
-	RETR_TEST_EN = 1;  // 빌리지 케이르 단락 검사 활성화
+    if (st_cable.step != CABLE_STEP_WAIT) {
+        return;
+    }
 
-	//delay for PMIC
-	while(!RETR_CABLE_STATUS) {
-		// if too late, PMIC is fail
-	}
+    elapsed = (uint16)(osal_GetSystemClock() - st_cable.start_ms);
 
-	EN_CONN_RETR = 0;
-	delay_us(20);
+    if (!RETR_CABLE_STATUS) {
+        if (elapsed >= CABLE_TIMEOUT_MS) {
+            cable_check_finish(CABLE_PMIC_TIMEOUT, elapsed);
+        }
+        else {
+            osal_start_timerEx(st_cable.task_id, st_cable.evt, CABLE_POLL_MS);
+        }
+        return;
+    }
 
-	if(!RETR_CABLE_STATUS) {
-		//cable is broken
-		cable_status = 1;
-	}
-	RETR_TEST_EN = 0;
+    //PMIC 응답, 코넥터 출력을 끊어도 상태가 유지되어야 정상
+    EN_CONN_RETR = 0;
+    delay_us(CABLE_SETTLE_US);
 
-	return cable_status;
+    cable_check_finish(RETR_CABLE_STATUS ? CABLE_OK : CABLE_BROKEN, elapsed);
 }
 
 void sensor_status_init(sensor_info_t *p_sensor)
@@ -42,21 +100,316 @@ void sensor_status_init(sensor_info_t *p_sensor)
 
 void init_batt_status_info(batt_info_t *p_battStatus)
 {
-    p_battStatus->batt_v = read_voltage(READ_BATT_SIDE);
+    p_battStatus->batt_mv = read_voltage(READ_BATT_SIDE);
     p_battStatus->hysteresis_cnt = 0;
     p_battStatus->current = 0;
 }
 
-int16 read_temperature()
+/**
+ * @fn ocv_to_mah
+ * @brief 휴지 상태 전압으로 남은 용량을 추정, table 사이는 선형 보간
+ */
+static uint16 ocv_to_mah(uint16 ocv_mv)
+{
+    uint8 i;
+    uint32 soc_x10;     //0.1% 단위
+
+    if (ocv_mv <= ocv_table[0]) {
+        return 0;
+    }
+    if (ocv_mv >= ocv_table[CC_OCV_POINTS - 1]) {
+        return BATT_CAPACITY_MAH;
+    }
+
+    for (i = 1; ocv_mv > ocv_table[i]; i++);
+
+    soc_x10 = (uint32)(i - 1) * 100 +
+              (uint32)(ocv_mv - ocv_table[i - 1]) * 100 / (ocv_table[i] - ocv_table[i - 1]);
+
+    return (uint16)(soc_x10 * BATT_CAPACITY_MAH / 1000);
+}
+
+/**
+ * @fn batt_soc_persist
+ * @brief 남은 용량과 누적 충/방전량을 기록 단위가 바뀐 경우에만 설정 저장소에 기록
+ */
+static void batt_soc_persist(batt_info_t *apst_batt, uint8 force)
+{
+    uint16 diff;
+
+    diff = (apst_batt->remain_mah > st_cc.saved_mah) ? apst_batt->remain_mah - st_cc.saved_mah
+                                                      : st_cc.saved_mah - apst_batt->remain_mah;
+    if (force || diff >= CC_PERSIST_MAH) {
+        settings_set(SET_KEY_SOC_MAH, apst_batt->remain_mah);
+        st_cc.saved_mah = apst_batt->remain_mah;
+    }
+
+    //같은 값이라면 settings_set에서 기록하지 않음
+    settings_set(SET_KEY_CHG_TOTAL, (uint16)(apst_batt->chg_mah / CC_TOTAL_UNIT));
+    settings_set(SET_KEY_DISCHG_TOTAL, (uint16)(apst_batt->dischg_mah / CC_TOTAL_UNIT));
+
+    apst_batt->soc = (uint8)((uint32)apst_batt->remain_mah * 100 / BATT_CAPACITY_MAH);
+}
+
+/**
+ * @fn batt_soc_init
+ * @brief 설정 저장소의 값으로 coulomb counter를 복구, 기록이 없다면 현재 전압으로 추정
+ *        settings_init 이후에 호출해야 함.
+ */
+void batt_soc_init(batt_info_t *apst_batt, uint32 now_ms)
+{
+    uint16 value;
+
+    osal_memset(&st_cc, 0, sizeof(st_cc));
+    st_cc.last_ms = now_ms;
+
+    if (settings_get(SET_KEY_SOC_MAH, &value) && value <= BATT_CAPACITY_MAH) {
+        apst_batt->remain_mah = value;
+        st_cc.saved_mah = value;
+    } else {
+        apst_batt->remain_mah = ocv_to_mah(read_voltage(READ_BATT_SIDE));
+        st_cc.saved_mah = ~apst_batt->remain_mah;
+    }
+
+    apst_batt->chg_mah = settings_get(SET_KEY_CHG_TOTAL, &value) ? (uint32)value * CC_TOTAL_UNIT : 0;
+    apst_batt->dischg_mah = settings_get(SET_KEY_DISCHG_TOTAL, &value) ? (uint32)value * CC_TOTAL_UNIT : 0;
+
+    batt_soc_persist(apst_batt, FALSE);
+}
+
+/**
+ * @fn batt_rest_reset
+ * @brief 휴지 상태가 끝남, 휴지 시간과 판정 구간을 새로 시작
+ */
+static void batt_rest_reset(void)
+{
+    st_cc.rest_ms = 0;
+    st_cc.rest_done = FALSE;
+    st_cc.win_acc = 0;
+    st_cc.win_ms = 0;
+}
+
+/**
+ * @fn batt_soc_update
+ * @brief 마지막 호출 이후의 시간 동안 현재 전류를 적분, 주기적으로 호출해야 함
+ *        CC_REST_WIN 구간 평균으로 판정한 휴지 상태가 CC_REST_TIME 이상 지속되면
+ *        OCV로 남은 용량을 다시 맞춤.
+ */
+void batt_soc_update(batt_info_t *apst_batt, uint32 now_ms)
+{
+    uint32 dt = now_ms - st_cc.last_ms;
+    int16 curr_ma;
+
+    st_cc.last_ms = now_ms;
+    if (dt > CC_MAX_DT) {
+        dt = CC_MAX_DT;
+    }
+
+    curr_ma = (int16)read_current(READ_CURR_CHG) - (int16)read_current(READ_CURR_DISCHG);
+    st_cc.acc += (int32)curr_ma * (int32)dt;
+
+    while (st_cc.acc >= CC_MAS_PER_MAH) {
+        st_cc.acc -= CC_MAS_PER_MAH;
+        apst_batt->chg_mah++;
+        if (apst_batt->remain_mah < BATT_CAPACITY_MAH) {
+            apst_batt->remain_mah++;
+        }
+    }
+    while (st_cc.acc <= -CC_MAS_PER_MAH) {
+        st_cc.acc += CC_MAS_PER_MAH;
+        apst_batt->dischg_mah++;
+        if (apst_batt->remain_mah) {
+            apst_batt->remain_mah--;
+        }
+    }
+
+    //한 샘플의 잡음으로 휴지 상태가 끊기지 않도록 구간 평균으로 판정, 큰 전류는 바로 반영
+    st_cc.win_acc += (int32)curr_ma * (int32)dt;
+    st_cc.win_ms += dt;
+    if (curr_ma > CC_REST_PEAK_MA || curr_ma < -CC_REST_PEAK_MA) {
+        batt_rest_reset();
+    } else if (st_cc.win_ms >= CC_REST_WIN) {
+        if (st_cc.win_acc > (int32)CC_REST_MA * (int32)st_cc.win_ms
+            || st_cc.win_acc < -(int32)CC_REST_MA * (int32)st_cc.win_ms) {
+            batt_rest_reset();
+        } else if (!st_cc.rest_done) {
+            st_cc.rest_ms += st_cc.win_ms;
+            if (st_cc.rest_ms >= CC_REST_TIME) {
+                //충분히 쉰 배터리 전압은 OCV에 가까움, 적분 오차를 제거
+                apst_batt->remain_mah = ocv_to_mah(read_voltage(READ_BATT_SIDE));
+                st_cc.acc = 0;
+                st_cc.rest_done = TRUE;
+            }
+        }
+        st_cc.win_acc = 0;
+        st_cc.win_ms = 0;
+    }
+
+    batt_soc_persist(apst_batt, FALSE);
+}
+
+/**
+ * @fn batt_soc_full
+ * @brief 만충 검출시 남은 용량을 최대 용량으로 맞추고 바로 기록
+ */
+void batt_soc_full(batt_info_t *apst_batt)
+{
+    apst_batt->remain_mah = BATT_CAPACITY_MAH;
+    st_cc.acc = 0;
+    batt_soc_persist(apst_batt, TRUE);
+}
+
+/**
+ * @fn temp_i2c_open
+ * @brief I2C는 처음 한번만 초기화
+ */
+static void temp_i2c_open(void)
+{
+    if (!st_temp.i2c_ready) {
+        HalI2CInit(i2cClock_33KHZ); //i2c interface drive clock is 33Khz
+        st_temp.i2c_ready = TRUE;
+    }
+}
+
+/**
+ * @fn temp_refresh
+ * @brief LM75에서 온도를 읽어 cache를 갱신
+ *        읽기에 실패하면 이전 값과 시각을 유지함
+ */
+static void temp_refresh(uint32 now_ms)
 {
     uint8 temp_arr[2] = { 0 };
     uint8 read_size = 2;
 
-    HalI2CInit(i2cClock_33KHZ); //i2c interface drive clock is 33Khz
-    HalI2CRead(LM75_ADDR, read_size, temp_arr);
+    temp_i2c_open();
+
+    if (HalI2CRead(LM75_ADDR, read_size, temp_arr) != read_size) {
+        return;
+    }
+
+    st_temp.value = calc_i2c_temperature(temp_arr);
+    st_temp.stamp_ms = now_ms;
+    st_temp.valid = TRUE;
+}
+
+/**
+ * @fn temp_service
+ * @brief 주기적으로 LM75를 읽어 cache 갱신, EVT_TEMP_READ에서 호출
+ */
+void temp_service(uint32 now_ms)
+{
+    temp_refresh(now_ms);
+}
+
+/**
+ * @fn lm75_write_temp
+ * @brief LM75 온도 설정 register(T_OS, T_HYST) 기록, 0.5도 단위 9bit 값을 상위 정렬
+ * 
+ * @return 0: 성공, 1: I2C 실패
+ */
+static uint8 lm75_write_temp(uint8 reg, int16 temp)
+{
+    uint8 buf[3];
+    int16 reg_val = (temp / 5) << 7;
+
+    buf[0] = reg;
+    buf[1] = (uint8)(reg_val >> 8);
+    buf[2] = (uint8)reg_val;
+
+    return (HalI2CWrite(LM75_ADDR, 3, buf) != 3);
+}
+
+/**
+ * @fn temp_alert_init
+ * @brief LM75의 T_OS/T_HYST와 OS 출력을 설정하고 OS pin 인터럽트를 켬
+ *        이미 과열 상태라면 edge가 없으므로 바로 event를 보냄
+ * 
+ * @param task_id, evt: 과열시 osal_set_event로 알릴 task와 event
+ * @return 0: 성공, 1: I2C 실패(인터럽트는 켜지 않음, 주기적인 온도 읽기만 동작)
+ */
+uint8 temp_alert_init(uint8 task_id, uint16 evt)
+{
+    uint8 buf[2];
+
+    temp_alert_task = task_id;
+    temp_alert_evt = evt;
+    temp_i2c_open();
+
+    buf[0] = LM75_REG_CONF;
+    buf[1] = LM75_CONF_FQ_2;
+    if (HalI2CWrite(LM75_ADDR, 2, buf) != 2
+        || lm75_write_temp(LM75_REG_TOS, TEMP_OVER)
+        || lm75_write_temp(LM75_REG_THYST, TEMP_OVER_HYST)) {
+        return 1;
+    }
+
+    //pointer를 온도 register로 돌려놓아야 이후 2byte 읽기가 온도가 됨
+    buf[0] = LM75_REG_TEMP;
+    if (HalI2CWrite(LM75_ADDR, 1, buf) != 1) {
+        return 1;
+    }
+
+    //port0 하강 edge 인터럽트
+    PICTL |= BIT0;
+    P0IFG = ~TEMP_OS_BIT;
+    P0IEN |= TEMP_OS_BIT;
+    P0IE = 1;
+
+    if (temp_alert_active()) {
+        osal_set_event(task_id, evt);
+    }
+
+    return 0;
+}
+
+/**
+ * @fn temp_alert_active
+ * @brief LM75 OS 출력 상태, T_OS 초과 후 T_HYST 미만으로 내려갈때까지 유지
+ */
+uint8 temp_alert_active(void)
+{
+    return (TEMP_OS_ALERT == 0);
+}
+
+/**
+ * @fn temp_alert_isr
+ * @brief LM75 OS 하강 edge, tick을 기다리지 않고 충/방전을 차단한 후 task에 알림
+ */
+HAL_ISR_FUNCTION(temp_alert_isr, P0INT_VECTOR)
+{
+    HAL_ENTER_ISR();
+
+    if (P0IFG & TEMP_OS_BIT) {
+        charge_disable();
+        discharge_disable();
+        if (temp_alert_task != TASK_NO_TASK) {
+            osal_set_event(temp_alert_task, temp_alert_evt);
+        }
+    }
+
+    //pin flag를 먼저 지워야 CPU flag가 다시 set되지 않음
+    P0IFG = ~TEMP_OS_BIT;
+    P0IF = 0;
+
+    HAL_EXIT_ISR();
+}
+
+/**
+ * @fn read_temperature
+ * @brief cache된 온도, I2C 통신 없음
+ *        cache가 TEMP_STALE_MS보다 오래되었으면 직접 읽어 갱신
+ * 
+ * @return 온도[0.1도]
+ */
+int16 read_temperature()
+{
+    uint32 now_ms = osal_GetSystemClock();
+
+    if (!st_temp.valid || now_ms - st_temp.stamp_ms > TEMP_STALE_MS) {
+        temp_refresh(now_ms);
+    }
 
-    //temperature value is 
-    return calc_i2c_temperature(temp_arr);
+    return st_temp.value;
 }
 
 static int16 calc_i2c_temperature(uint8 * i2c_data)
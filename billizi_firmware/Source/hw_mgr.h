@@ -8,6 +8,42 @@
 
 #define LM75_ADDR   0x48
 
+/* LM75 온도 cache
+ * EVT_TEMP_READ마다 temp_service가 한번 읽어 cache를 갱신하고 read_temperature는 cache를 반환함.
+ * cache가 TEMP_STALE_MS보다 오래되면(event 시작 전, I2C 실패 등) read_temperature에서 직접 읽음. */
+#define TEMP_PERIOD     1000    //LM75 읽기 주기(ms), OS pin이 없는 보드는 이 polling으로 과열 감지
+#define TEMP_STALE_MS   30000   //cache 허용 최대 경과 시간(ms)
+
+/* LM75 과열 출력(OS)
+ * 부팅시 T_OS/T_HYST를 설정하고, OS pin(TEMP_OS_ALERT)의 하강 edge 인터럽트에서 바로
+ * 충/방전을 차단한 뒤 등록된 task에 event를 보냄. comparator mode이므로 온도가
+ * T_HYST 아래로 내려갈때까지 OS가 유지되며 temp_alert_active로 확인함. */
+#define TEMP_OVER           700     //과열 판정 온도[0.1도], LM75 T_OS
+#define TEMP_OVER_HYST      650     //과열 해제 온도[0.1도], LM75 T_HYST
+#define LM75_REG_TEMP       0x00
+#define LM75_REG_CONF       0x01
+#define LM75_REG_THYST      0x02
+#define LM75_REG_TOS        0x03
+#define LM75_CONF_FQ_2      0x08    //comparator mode, OS active low, 2회 연속 초과시 출력
+#define TEMP_OS_BIT         BIT2    //P0IFG, P0IEN에서 TEMP_OS_ALERT 위치
+
+/* 빌리지 케이블 검사
+ * EN_CONN_RETR/RETR_TEST_EN을 켜서 PMIC를 깨운 뒤 바로 OSAL로 돌아가고, 등록된 task event에서
+ * CABLE_POLL_MS마다 cable_check_service가 RETR_CABLE_STATUS를 확인함.
+ * PMIC가 응답하면 EN_CONN_RETR을 끄고 CABLE_SETTLE_US 후 다시 읽어 단선을 판정하며,
+ * CABLE_TIMEOUT_MS 안에 응답이 없으면 PMIC 불량으로 끝냄. 결과와 응답시간은 callback으로 전달.
+ * 검사 중에는 EN_CONN_RETR을 사용하므로 빌리지 코넥터 방전을 시작하지 않아야 함. */
+#define CABLE_POLL_MS       2       //PMIC 응답 확인 주기(ms)
+#define CABLE_TIMEOUT_MS    1000    //PMIC 응답 대기 최대 시간(ms)
+#define CABLE_SETTLE_US     20      //EN_CONN_RETR을 끈 후 판정까지 대기(us)
+
+#define CABLE_OK            0
+#define CABLE_BROKEN        1       //PMIC는 응답했으나 케이블 단선
+#define CABLE_PMIC_TIMEOUT  2       //PMIC 무응답
+
+#define CABLE_STEP_IDLE     0
+#define CABLE_STEP_WAIT     1       //PMIC 응답 대기
+
 #define ERR_BROKEN_CABLE    0x01
 #define ERR_FLASH_MEMS      0x02
 #define ERR_TEMP_OVER       0x04
@@ -37,23 +73,81 @@ typedef union _ctrl_flag
     uint16 flag_all;
 }Control_flag_t;
 
+/* coulomb counter
+ * shunt 전류(충전 +, 방전 -)를 시간에 대해 적분하여 남은 용량과 누적 충/방전량을 계산.
+ * 휴지 상태(CC_REST_WIN 구간 평균 전류가 CC_REST_MA 이하)가 CC_REST_TIME 이상 지속되면 OCV로,
+ * 만충 검출시 최대 용량으로 보정함.
+ * 남은 용량은 CC_PERSIST_MAH 이상 바뀔때, 누적량은 CC_TOTAL_UNIT마다 설정 저장소에 기록되어
+ * 재부팅 후에도 이어서 계산됨 (기록 단위 미만의 누적량은 재부팅시 버려짐). */
+#define CC_MAS_PER_MAH      3600000     //1mAh = 3600000 mA*ms
+#define CC_MAX_DT           1000        //한번에 적분할 최대 시간(ms), event가 밀린 경우 과적분 방지
+#define CC_REST_MA          20          //CC_REST_WIN 평균 전류가 이하면 휴지 상태로 봄
+#define CC_REST_WIN         60000       //휴지 판정 평균 구간(ms), 측정 잡음(약 14mA rms)을 평균으로 줄임
+#define CC_REST_PEAK_MA     200         //한번이라도 넘으면 바로 휴지 상태가 끝남, 측정 잡음보다 충분히 크게
+#define CC_REST_TIME        1800000     //OCV 보정을 위한 휴지 시간(ms), 30분
+#define CC_PERSIST_MAH      48          //남은 용량 기록 간격(mAh), 약 1%
+#define CC_TOTAL_UNIT       100         //누적 충/방전량 기록 단위(mAh)
+#define CC_OCV_POINTS       11          //OCV table 개수, 0~100% 10% 간격
+
 typedef struct _BATT_STATUS {
-    float batt_v;
+    uint16 batt_mv;     //배터리 전압[mV]
     uint16 current;
     uint16 hysteresis_cnt;
+    uint8 soc;          //state of charge[%]
+    uint16 remain_mah;  //남은 용량[mAh]
+    uint32 chg_mah;     //누적 충전량[mAh]
+    uint32 dischg_mah;  //누적 방전량[mAh]
 }batt_info_t;
 
+typedef struct _COULOMB_CNT {
+    int32 acc;          //1mAh 미만의 적분값(mA*ms)
+    uint32 last_ms;     //마지막 적분 시각
+    uint32 rest_ms;     //휴지 상태 지속 시간
+    int32 win_acc;      //휴지 판정 구간의 전류 적분값(mA*ms)
+    uint32 win_ms;      //휴지 판정 구간의 경과 시간
+    uint8 rest_done;    //이번 휴지 상태에서 OCV 보정을 했는지
+    uint16 saved_mah;   //마지막으로 기록한 남은 용량
+}coulomb_cnt_t;
+
+typedef struct _TEMP_CACHE {
+    int16 value;        //온도[0.1도]
+    uint32 stamp_ms;    //value를 읽은 시각
+    uint8 valid;        //한번이라도 읽었는지
+    uint8 i2c_ready;    //I2C 초기화 여부
+}temp_cache_t;
+
+/**
+ * @brief 케이블 검사 완료 callback
+ * @param result CABLE_OK, CABLE_BROKEN, CABLE_PMIC_TIMEOUT
+ * @param resp_ms 검사 시작부터 PMIC 응답까지 걸린 시간(ms), 무응답이면 대기한 시간
+ */
+typedef void (*cable_cb_t)(uint8 result, uint16 resp_ms);
+
+typedef struct _CABLE_CHECK {
+    cable_cb_t p_cb;
+    uint32 start_ms;    //pin을 켠 시각
+    uint16 evt;
+    uint8 task_id;
+    uint8 step;         //CABLE_STEP_XXX
+}cable_check_t;
+
 typedef struct _SENSOR_STATUS {
     uint16 impact_cnt;
     uint16 temperature;
 }sensor_info_t;
 
-static int16 calc_i2c_temperature(uint8 * i2c_data);
-
 void init_batt_status_info(batt_info_t *p_battStatus);
 
+void batt_soc_init(batt_info_t *apst_batt, uint32 now_ms);
+void batt_soc_update(batt_info_t *apst_batt, uint32 now_ms);
+void batt_soc_full(batt_info_t *apst_batt);
+
 int16 read_temperature();
-//uint8 check_cable_status();
+void temp_service(uint32 now_ms);
+uint8 temp_alert_init(uint8 task_id, uint16 evt);
+uint8 temp_alert_active(void);
+uint8 cable_check_start(uint8 task_id, uint16 evt, cable_cb_t p_cb);
+void cable_check_service(void);
 
 void sensor_status_init(sensor_info_t *p_sensor);
 
@@ -1,16 +1,54 @@
 #include "log_mgr.h"
 
+//부팅 이후 플래시에 기록 완료된 로그 개수
+static uint32 log_commit_cnt = 0;
+
+//미리 지워둔 로그페이지 bitmap 및 기록중 페이지 지우기 통계
+static uint8 pre_erased[(LOG_PAGE_ED - LOG_PAGE_ST + 8) / 8];
+static uint16 erase_avoided_cnt = 0;
+static uint16 erase_inline_cnt = 0;
+
+//ring별 페이지 범위 (시작 페이지, 페이지 개수)
+static const uint8 log_ring_pages[LOG_RING_CNT][2] = {
+    {LOG_RING_CHG_ST, LOG_RING_CHG_PAGES},
+    {LOG_RING_DISCHG_ST, LOG_RING_DISCHG_PAGES},
+    {LOG_RING_EVT_ST, LOG_RING_EVT_PAGES},
+};
+
+//로그가 비어있을때 ring별 첫 로그를 시작할 페이지 (가장 적게 지워진 페이지), 첫 페이지를 열면 다시 탐색
+static uint8 log_start_pg[LOG_RING_CNT];
+
+//플래시 기록 대기중인 ring별 로그 RAM 버퍼 (로그 데이터, 로그 발생 시각)
+typedef struct _LOG_STAGE {
+    uint32 log[LOG_STAGE_SIZE];
+    uint32 time[LOG_STAGE_SIZE];
+    uint8 head;
+    uint8 tail;
+    uint8 cnt;
+}log_stage_t;
+
+static log_stage_t log_stage[LOG_RING_CNT];
+
+//로그 읽기 window: LOG_READ_WIN 단위로 정렬된 영역을 한번에 읽어 RAM에 보관
+static uint32 read_win[LOG_READ_WIN];
+static uint16 read_win_addr = 0;
+static uint8 read_win_valid = FALSE;
+
 /******************************************************************
  * @command - log manager 내의 변수들 기본 개념
- * key - 해당 소스의 key개념은 각 로그의 마지막 주소를 가리키는 변수를 말함.
- * key_address - key값을 저장한 플래시메모리의 주소.
- * 
  * head_log - 각 log의 시작이 되는 로그
  * tail_log - 각 log의 마지막이 되는 로그, log_value로 head_log의 위치를 가짐.
  * 
- * 메모리에 저장시 key값은 16bit로 나타내는 로그의 주소. 즉, 16bit로 저장됨.
- * 32bit 영역을 16bit로 나누어 상위/하위에 저장하여 메모리 활용도를 증가시킴
- * 쓰기는 하위16bit부터 쓰여짐.
+ * page_header - 로그 영역 각 페이지의 첫 LOG_PAGE_HDR_SIZE(5)word, wear/open/base time/close/index word로 구성.
+ *               부팅시 페이지 헤더만 읽어 마지막 로그 위치를 복구함.
+ * 
+ * log_record - 로그 1개는 1word, 시각은 직전 로그와의 시간차로 기록됨.
+ *              절대 시각은 페이지 헤더와 time record에만 기록됨.
+ * 
+ * commit_marker - 로그 세션(head ~ tail)의 마지막 word, tail log 다음에 기록됨.
+ *                 commit marker가 없는 세션은 기록 도중 중단된 세션으로 판단함.
+ * 
+ * ring - 스트림(충전, 방전/대여, 이상 이벤트)별 페이지 범위, log_addr_t 하나가 ring 하나를 담당함.
  */
 
 /**
@@ -19,395 +57,1672 @@
  * 
  * @param apst_log: 로그데이터에 해당하는 스트럭쳐 변수
  * @param apst_addr: log_data를 저장할 위치를 가지고있을 주소 스트럭쳐
+ * @param ring: 주소 스트럭쳐가 사용할 로그 ring (LOG_RING_XXX)
  */
-uint8 log_system_init(log_data_t *apst_log, log_addr_t *apst_addr) 
+uint8 log_system_init(log_data_t *apst_log, log_addr_t *apst_addr, uint8 ring) 
 {
     //log data structure initialize
     apst_log->data_all = 0;
 
     //log address information structure initialize
-    apst_addr->key_addr = 0;
     apst_addr->head_addr = 0;
     apst_addr->offset_addr = 0;
     apst_addr->tail_addr = 0;
     apst_addr->log_cnt = 0;
 
-    return 0;
+    apst_addr->page_seq = 0;
+    apst_addr->page_cnt = 0;
+    apst_addr->page_head = NO_HEAD_OFFSET;
+
+    apst_addr->last_time = LOG_TIME_UNKNOWN;
+    apst_addr->read_time = 0;
+    apst_addr->sess_seq = 0;
+    apst_addr->page_evt = 0;
+    apst_addr->page_kind = 0;
+    apst_addr->page_mono = FALSE;
+
+    apst_addr->ring = ring;
+    apst_addr->pg_st = log_ring_pages[ring][0];
+    apst_addr->pg_ed = log_ring_pages[ring][0] + log_ring_pages[ring][1] - 1;
+
+    //페이지 헤더를 이용하여 마지막 로그 위치 복구
+    return recover_log_addresses(apst_addr);
+}
+
+/**
+ * @fn ring_addr_valid
+ * @brief 주소가 apst_addr의 ring 페이지 범위 안에 있는지 확인
+ */
+static uint8 ring_addr_valid(log_addr_t *apst_addr, uint16 addr)
+{
+    return (ADDR_2_PAGE(addr) >= apst_addr->pg_st && ADDR_2_PAGE(addr) <= apst_addr->pg_ed);
+}
+
+/**
+ * @fn ring_wrap_addr
+ * @brief ring의 마지막 페이지를 넘어간 주소를 ring의 첫 페이지로 되돌림
+ */
+static uint16 ring_wrap_addr(log_addr_t *apst_addr, uint16 addr)
+{
+    if (ADDR_2_PAGE(addr) > apst_addr->pg_ed) {
+        return PAGE_2_ADDR(apst_addr->pg_st);
+    }
+    return addr;
 }
 
 /**
- * @fn LogAddress_valid_check
- * @brief 변수로 받은 주소가 로그로 사용할 주소에 해당하는지 확인
- *        주소 값이 잘못되었다면 FALSE 반환
+ * @fn read_log_page_hdr
+ * @brief 로그 페이지의 헤더(LOG_PAGE_HDR_SIZE word)를 한번의 플래시 읽기로 가져옴
  * 
- * @param addr: 플래시의 주소 값
+ * @param pg: 로그 페이지 번호
+ * @param apst_hdr: 읽어들인 헤더를 받을 포인터 변수
+ */
+void read_log_page_hdr(uint8 pg, log_page_hdr_t *apst_hdr)
+{
+    read_flash_bulk(PAGE_2_ADDR(pg), apst_hdr, LOG_PAGE_HDR_SIZE);
+}
+
+/**
+ * @fn read_log_word
+ * @brief 로그 영역의 word 하나를 읽기 window를 통해 읽음
+ *        window 밖의 주소라면 해당 주소를 포함하는 LOG_READ_WIN word를 한번에 읽어둠.
+ *        window는 페이지 안에서 정렬되므로 순방향/역방향 탐색 모두 window를 재사용함.
+ */
+static uint32 read_log_word(uint16 addr)
+{
+    uint16 win_addr = addr & ~(LOG_READ_WIN - 1);
+
+    if (!read_win_valid || win_addr != read_win_addr) {
+        read_flash_bulk(win_addr, read_win, LOG_READ_WIN);
+        read_win_addr = win_addr;
+        read_win_valid = TRUE;
+    }
+
+    return read_win[addr - win_addr];
+}
+
+/**
+ * @fn valid_log_page
+ * @brief 페이지 헤더가 읽을 수 있는 버전의 열린/닫힌 로그페이지인지 확인
  */
-uint8 LogAddress_valid_check(uint16 addr)
+static uint8 valid_log_page(log_page_hdr_t *apst_hdr)
 {
-    if(addr < FLADDR_LOGDATA_ST || addr > FLADDR_LOGDATA_ED) {                                                                      
+    if (apst_hdr->open.version < LOG_PAGE_VERSION_MIN || apst_hdr->open.version > LOG_PAGE_VERSION) {
+        return FALSE;
+    }
+
+    if (apst_hdr->open.state != PAGE_ST_OPEN && apst_hdr->open.state != PAGE_ST_FULL) {
+        return FALSE;
+    }
+
+    //base time이 없다면 헤더를 기록하는 도중 전원이 차단된 페이지
+    if (apst_hdr->base_time == LOG_TIME_UNKNOWN) {
         return FALSE;
     }
+
     return TRUE;
 }
 
 /**
- * @fn      get_key_address
- * @brief   저장된 key로그들 중에서 가장 마지막에 저장된 key로그위치를 반환
- * 
- * @return  key_addr: 가장 최근의 키로그가 기록되어있는 플래시 주소
- *                   만약, 키로그가 없는 상태라면 키로그의 시작주소 반환
+ * @fn page_first_rec
+ * @brief 페이지 형식에 따른 첫 로그의 offset, 이전 형식의 페이지를 그대로 읽기 위해 사용
+ *        로그페이지가 아니라면 현재 형식의 값을 반환
+ */
+static uint16 page_first_rec(uint8 pg)
+{
+    log_page_hdr_t page_hdr;
+
+    read_log_page_hdr(pg, &page_hdr);
+    if (!valid_log_page(&page_hdr)) {
+        return LOG_PAGE_HDR_SIZE;
+    }
+
+    return page_hdr.open.first_rec;
+}
+
+/**
+ * @fn log_page_open
+ * @brief 아직 닫히지 않은 페이지인지 확인
+ *        close word의 rec_cnt, last_head 중 하나라도 기록되었다면 닫는 도중이었더라도 닫힌 페이지
  */
-uint16 get_key_address()
+static uint8 log_page_open(log_page_hdr_t *apst_hdr)
 {
-    uint16 key_addr = FLADDR_LOGKEY_ED;
-    flash_16bit_t key_value;
+    return (apst_hdr->open.state == PAGE_ST_OPEN &&
+            apst_hdr->close.rec_cnt == PG_END_OFFSET && apst_hdr->close.last_head == PG_END_OFFSET);
+}
 
-    /* search last valid key location 
-     * 마지막 key log 주소 -> 첫번째 key log 주소로 역순 탐색
-     */
-    while (key_addr >= FLADDR_LOGKEY_ST) {
-        read_flash(key_addr, FLOPT_UINT32, &key_value.all_bits);
+/**
+ * @fn prev_log_page
+ * @brief ring 상에서 이전 로그페이지 번호 반환
+ */
+static uint8 prev_log_page(log_addr_t *apst_addr, uint8 pg)
+{
+    if (pg <= apst_addr->pg_st) {
+        return apst_addr->pg_ed;
+    }
+    return pg - 1;
+}
 
-        //32bit의 플래시 값중 쓰여진 값이 있다면 해당위치에서 while 탈출
-        if (key_value.all_bits != EMPTY_FLASH) {
-            break;
-        }
-        key_addr--;
+/**
+ * @fn next_log_page
+ * @brief ring 상에서 다음 로그페이지 번호 반환
+ */
+static uint8 next_log_page(log_addr_t *apst_addr, uint8 pg)
+{
+    if (pg >= apst_addr->pg_ed) {
+        return apst_addr->pg_st;
+    }
+    return pg + 1;
+}
+
+/**
+ * @fn log_page_wear
+ * @brief 로그페이지의 지우기 횟수, 횟수가 없는 페이지는 ring 상의 앞/뒤 페이지로 추정
+ *        (ring 경계 페이지가 다른 ring의 페이지로 추정되지 않도록)
+ */
+static uint32 log_page_wear(log_addr_t *apst_addr, uint8 pg)
+{
+    return get_page_wear_near(pg, prev_log_page(apst_addr, pg), next_log_page(apst_addr, pg));
+}
+
+/**
+ * @fn log_page_erase
+ * @brief 로그페이지 지우기, 지우기 횟수 추정은 log_page_wear와 같음
+ */
+static void log_page_erase(log_addr_t *apst_addr, uint8 pg)
+{
+    flash_page_erase_near(pg, prev_log_page(apst_addr, pg), next_log_page(apst_addr, pg));
+}
+
+/**
+ * @fn log_page_blank
+ * @brief wear word를 제외한 페이지 내용이 비어있는지 확인
+ */
+static uint8 log_page_blank(uint8 pg)
+{
+    uint16 st_addr = PAGE_2_ADDR(pg) + FLASH_WEAR_OFFSET + 1;
+
+    return (search_fill_boundary(st_addr, PAGE_2_ADDR(pg) + PG_END_OFFSET) == st_addr);
+}
+
+/**
+ * @fn least_worn_log_page
+ * @brief ring에서 지우기 횟수가 가장 적은 페이지 반환
+ *        로그가 비어있을때만 사용됨. 미리 지우기와 페이지 열기가 같은 페이지를 고르도록
+ *        ring이 첫 페이지를 열때까지 탐색 결과를 유지함.
+ */
+static uint8 least_worn_log_page(log_addr_t *apst_addr)
+{
+    uint32 erase_cnt, min_cnt = EMPTY_FLASH;
+    uint8 *p_start = &log_start_pg[apst_addr->ring];
+    uint8 pg;
+
+    if (*p_start) {
+        return *p_start;
     }
 
-    //key_addr 변수가 계속 줄어들어 while 탈출시 시작주소로 초기화
-    if(key_addr < FLADDR_LOGKEY_ST) {
-        key_addr = FLADDR_LOGKEY_ST;
+    for (pg = apst_addr->pg_st; pg <= apst_addr->pg_ed; pg++) {
+        erase_cnt = log_page_wear(apst_addr, pg);
+        if (erase_cnt < min_cnt) {
+            min_cnt = erase_cnt;
+            *p_start = pg;
+        }
     }
 
-    return key_addr;
+    return *p_start;
 }
 
 /**
- * @fn addr_available_check_16bit
- * @brief 해당 주소가 16bit를 쓸수 있는 유효주소인지 판별
+ * @fn open_log_page
+ * @brief offset_addr가 가리키는 페이지를 지우고 새 페이지 헤더를 기록
+ *        미리 지워둔 페이지라면 지우기를 생략함.
  * 
- * @param addr: 사용할 플래시 주소
+ * @param base_time: 페이지 첫 로그의 시각, 헤더에 기준 시각으로 기록됨
  * 
- * @see 사용법 참조 -> function: stored_key_addres
- * 
- * @todo return 값을 enum으로 변경하여 활용하기 편하게 변경하는게 좋아보임.
+ * @return error=1||success=0
  */
-uint8 addr_available_check_16bit(uint16 addr)
+static uint8 open_log_page(log_addr_t *apst_addr, uint32 base_time)
 {
-    flash_16bit_t flash_value;  //flash의 값을 저장할 변수
+    log_page_hdr_t page_hdr;
+    uint8 pg = ADDR_2_PAGE(apst_addr->offset_addr);
+    uint8 pg_idx = pg - LOG_PAGE_ST;
+
+    if (pre_erased[pg_idx >> 3] & (1 << (pg_idx & 0x07))) {
+        pre_erased[pg_idx >> 3] &= ~(1 << (pg_idx & 0x07));
+        erase_avoided_cnt++;
+    } else if (!log_page_blank(pg)) {
+        //미리 지워지지 않은 페이지, 기록중에 페이지 지우기 발생
+        log_page_erase(apst_addr, pg);
+        erase_inline_cnt++;
+    }
+
+    read_win_valid = FALSE;
+    log_start_pg[apst_addr->ring] = 0;
+
+    apst_addr->page_seq++;
+    apst_addr->page_cnt = 0;
+    apst_addr->page_head = NO_HEAD_OFFSET;
+    apst_addr->page_evt = 0;
+    apst_addr->page_kind = 0;
+    apst_addr->page_mono = TRUE;
 
-    read_flash(addr, FLOPT_UINT32, &flash_value.all_bits);
+    page_hdr.open.data_all = EMPTY_FLASH;
+    page_hdr.open.seq = apst_addr->page_seq;
+    page_hdr.open.first_rec = LOG_PAGE_HDR_SIZE;
+    page_hdr.open.state = PAGE_ST_OPEN;
+    page_hdr.open.version = LOG_PAGE_VERSION;
+    page_hdr.base_time = base_time;
+    page_hdr.close.data_all = EMPTY_FLASH;
+    page_hdr.close.sess_seq = apst_addr->sess_seq;
 
-    /** 
-     * 읽어들인 플래시값 32bit를 16bit로 나누어
-     * 상위/하위 16bit 중 한곳이라도 비어있으면(쓰기가능한상태 = 1) 해당 주소는 사용가능
-     */
-    if (flash_value.low_16bit == 0xFFFF) {
+    //open word, base time, close word(sess_seq)를 한번에 기록, 나머지 close 정보와 index는 페이지를 닫을때 기록
+    if (write_flash_burst(PAGE_2_ADDR(pg) + 1, &page_hdr.open.data_all, LOG_HDR_OPEN_WORDS)) {
         return 1;
-    } else if (flash_value.high_16bit == 0xFFFF) {
-        return 2;
     }
 
-    //no available address.
+    apst_addr->offset_addr = PAGE_2_ADDR(pg) + LOG_PAGE_HDR_SIZE;
+    apst_addr->last_time = base_time;
+
     return 0;
 }
 
 /**
- * @fn stroed_key_value
- * 
- * @brief key_value를 유효한 key address에 저장하는 함수
- * 
- * @param apst_addr: 로그에 대한 주소값들을 가지고있는 스트럭쳐 변수
+ * @fn log_time_span
+ * @brief 페이지 base time부터 마지막 로그 시각까지의 시간
+ *        페이지 안에서 시각이 되돌아갔거나 index word 범위를 넘으면 LOG_SPAN_UNKNOWN
  */
-void stroed_key_value(log_addr_t *apst_addr)
+static uint32 log_time_span(log_addr_t *apst_addr, uint32 base_time)
 {
-    uint8 address_use = 0;  //address가 유효한 주소인지 판단하는 값
-    flash_16bit_t key_value;
+    uint32 last_time = apst_addr->last_time;
 
-    //apst_addr이 가지고있는 key_address 값이 0일경우 값 초기화
-    if(apst_addr->key_addr == 0) {
-        apst_addr->key_addr = FLADDR_LOGKEY_ST;
+    if (!apst_addr->page_mono || last_time == LOG_TIME_UNKNOWN || last_time < base_time ||
+        last_time - base_time >= LOG_SPAN_UNKNOWN) {
+        return LOG_SPAN_UNKNOWN;
     }
+    return last_time - base_time;
+}
 
-    //현재 key_addr값이 유효한지 검사 및 유효값 탐색
-    while(!address_use) {
-        address_use = addr_available_check_16bit(apst_addr->key_addr);
-
-        //address_use의 값이 0이라면 해당 주소는 사용할 수 없는 주소
-        if(!address_use) {
-            //key_address값을 바꾸어 유효한 주소 탐색
-            apst_addr->key_addr = KEYADDR_VALIDATION(apst_addr->key_addr + 1);
+/**
+ * @fn close_log_page
+ * @brief 가득찬 로그페이지에 index, 사용한 word 개수와 head log 위치를 기록하고 FULL 상태로 변경
+ *        index word, close word 순서로 기록하고 open word의 상태 비트를 마지막에 기록함.
+ *        close word가 이미 기록된 페이지(닫는 도중 전원 차단)는 다시 기록하지 않음.
+ */
+static void close_log_page(log_addr_t *apst_addr, uint8 pg)
+{
+    log_page_hdr_t page_hdr;
 
-            //마지막 key 주소를 초과하여 시작주소로 돌아온경우 해당 플레시의 페이지를 지워 초기화
-            if(apst_addr->key_addr == FLADDR_LOGKEY_ST) {
-                HalFlashErase(ADDR_2_PAGE(FLADDR_LOGKEY_ST));
-            }
-        }
+    read_log_page_hdr(pg, &page_hdr);
+    if (!valid_log_page(&page_hdr) || !log_page_open(&page_hdr)) {
+        return;
     }
 
-    //key_value 변수 초기화
-    key_value.all_bits = EMPTY_FLASH;
-    switch(address_use) {
-        //addr_available_check_16bit의 함수를 통과하여 유효한 영역에 key에 해당하는 값 대입
-        case 1:
-            key_value.low_16bit = apst_addr->tail_addr;
-            break;
-        case 2:
-            key_value.high_16bit = apst_addr->tail_addr;
-            break;
-    }
+    page_hdr.close.rec_cnt = apst_addr->page_cnt;
+    page_hdr.close.last_head = apst_addr->page_head;
+    page_hdr.open.state = PAGE_ST_FULL;
+    read_win_valid = FALSE;
 
-    write_flash(apst_addr->key_addr, &key_value.all_bits);
+    /* 기록 도중 끊긴 index word는 지워지지 않은 bit가 남아 실제보다 넓은 범위를 가리키므로
+     * 검색에서 페이지를 놓치지 않음, 다시 기록하지 않음. index가 없는 이전 형식은 로그 영역임 */
+    if (LOG_PAGE_HAS_INDEX(page_hdr.open.version) && page_hdr.index.data_all == EMPTY_FLASH) {
+        page_hdr.index.evt_mask = apst_addr->page_evt;
+        page_hdr.index.kind_mask = apst_addr->page_kind;
+        page_hdr.index.span = log_time_span(apst_addr, page_hdr.base_time);
+        write_flash_burst(PAGE_2_ADDR(pg) + LOG_HDR_INDEX_OFFSET, &page_hdr.index.data_all, 1);
+    }
+    write_flash_burst(PAGE_2_ADDR(pg) + LOG_HDR_CLOSE_OFFSET, &page_hdr.close.data_all, 1);
+    write_flash_burst(PAGE_2_ADDR(pg) + 1, &page_hdr.open.data_all, 1);
 }
 
 /**
- * @fn analysis_keylog
- * @brief 받은 key주소의 key값을 분석하여 반환
- *        key값은 tail_log의 주소
+ * @fn log_word_need
+ * @brief 로그 1개를 기록하는데 필요한 word 수 계산
+ *        시간차를 delta_t로 표현할 수 없거나 head log라면 time record가 추가됨.
+ *        단, 페이지 첫 로그의 head log는 헤더의 base time이 시각을 대신함.
  * 
- * @return tail_log_address || error=0
+ * @return 1 || 2(time record + 로그)
  */
-uint16 analysis_keylog(uint16 key_addr)
+static uint8 log_word_need(uint8 log_type, uint32 time, uint32 last_time, uint8 page_first)
 {
-    flash_16bit_t key_value;
-
-    read_flash(key_addr, FLOPT_UINT32, &key_value.all_bits);
-    
-    //해당 주소의 값이 쓰여있지 않은 상태면 0반환
-    if(key_value.all_bits == EMPTY_FLASH) {
-        return 0;
+    if (log_type == TYPE_HEAD_LOG && !page_first) {
+        return LOG_RECORD_MAX_WORDS;
     }
-    
-    /**
-     * 하위영역부터 쓰여지므로 상위16bit에 값이 있다면
-     * 상위 16bit값이 최근 기록된 값으로 상위 16bit 리턴
-     */
-    if(key_value.high_16bit != 0xFFFF) {
-        return key_value.high_16bit;
-    }else {
-        return key_value.low_16bit;
+
+    if (time < last_time || time - last_time > LOG_DELTA_MAX) {
+        return LOG_RECORD_MAX_WORDS;
     }
+
+    return LOG_RECORD_SIZE;
 }
 
 /**
- * @fn analysis_tail_log 
- * @brief tail_log 의 주소를 받아 해당 로그가 tail로그인지
- *        확인 및 분석하여 head_log의 주소 반환
+ * @fn encode_log_word
+ * @brief 로그 데이터와 발생 시각을 플래시 기록 형식(log_word_t)으로 변환
  * 
- * @return head_addr||error=0
+ * @param need: log_word_need로 계산된 word 수
+ * @param p_words: 변환된 word를 받을 배열, need 만큼 채워짐
  */
-uint16 analysis_tail_log(uint16 tail_addr)
+static void encode_log_word(log_data_t *apst_data, uint32 time, uint32 last_time, uint8 need, uint32 *p_words)
 {
-    log_data_t tmp_log;
-    uint16 head_addr;
+    log_word_t word;
 
-    read_flash(tail_addr, FLOPT_UINT32, &tmp_log);
+    if (need == LOG_RECORD_MAX_WORDS) {
+        word.data_all = 0;
+        word.time.time_value = time;
+        word.time.log_type = TYPE_TIME_LOG;
+        *p_words++ = word.data_all;
+        last_time = time;
+    }
 
-    if(tmp_log.log_type != TYPE_TAIL_LOG) {
-        //tail log 플레그가 아닐경우 error값으로 0 반환
-        return 0;
+    word.data_all = 0;
+    if (apst_data->log_type == TYPE_EXT_LOG) {
+        //텔레메트리 record는 시간차 없이 직전 로그 시각을 따름
+        word.ext.ext_value = apst_data->log_value;
+        word.ext.log_type = TYPE_EXT_LOG;
+        word.ext.ext_type = LOG_EXT_TYPE(apst_data->log_evt, apst_data->data_type);
     } else {
-        //tail 로그는 log_value로 head_log의 주소를 가지고 있고 이를 반환
-        head_addr = tmp_log.log_value;
+        word.rec.log_evt = apst_data->log_evt;
+        word.rec.log_value = apst_data->log_value;
+        word.rec.log_type = apst_data->log_type;
+        word.rec.delta_t = time - last_time;
     }
+    *p_words = word.data_all;
+}
+
+/**
+ * @fn is_ext_record
+ * @brief 읽어들인 word가 extended record(time, 텔레메트리)인지 확인, 비어있는 word는 제외
+ */
+static uint8 is_ext_record(log_word_t *apst_word)
+{
+    return (apst_word->data_all != EMPTY_FLASH && apst_word->ext.log_type == TYPE_EXT_LOG);
+}
+
+/**
+ * @fn is_time_record
+ * @brief 읽어들인 word가 time record인지 확인
+ */
+static uint8 is_time_record(log_word_t *apst_word)
+{
+    return (is_ext_record(apst_word) && apst_word->time.ext_type == LOG_STAT_TIME);
+}
 
-    return head_addr;
+/**
+ * @fn is_commit_record
+ * @brief 읽어들인 word가 온전히 기록된 commit marker인지 확인
+ */
+static uint8 is_commit_record(log_word_t *apst_word)
+{
+    return (is_ext_record(apst_word) &&
+            apst_word->commit.ext_type == LOG_EXT_TYPE(LOG_STAT_COMMIT, LOG_ITEM_NONE) &&
+            apst_word->commit.check == LOG_COMMIT_CHECK(apst_word->commit.sess_seq));
 }
 
 /**
- * @fn get_newly_addresses
- * @brief 가장 최근 기록된 로그의 주소들을 가져옴
+ * @fn decode_log_word
+ * @brief 플래시 기록 형식(log_word_t)을 로그 데이터(log_data_t)로 변환, encode_log_word의 역변환
+ *        time record와 commit marker는 로그가 아니므로 호출전에 걸러내야 함.
  * 
- * @param apst_addr: 로그의 주소들을 받을 포인터 변수
+ * @param p_time: 직전 로그의 시각, normal/head/tail log라면 delta_t가 더해짐
  */
-void get_newly_addresses(log_addr_t *apst_addr)
+static void decode_log_word(log_word_t *apst_word, log_data_t *apst_data, uint32 *p_time)
 {
-    apst_addr->key_addr = get_key_address();
-    apst_addr->tail_addr = analysis_keylog(apst_addr->key_addr);
-    apst_addr->head_addr = analysis_tail_log(apst_addr->tail_addr);
+    apst_data->data_all = 0;
+    if (is_ext_record(apst_word)) {
+        //텔레메트리 record: log_evt = 통계 종류, data_type = 항목
+        apst_data->log_evt = apst_word->ext.ext_type >> 3;
+        apst_data->log_value = apst_word->ext.ext_value;
+        apst_data->log_type = TYPE_EXT_LOG;
+        apst_data->data_type = apst_word->ext.ext_type & 0x07;
+    } else {
+        *p_time += apst_word->rec.delta_t;
+        apst_data->log_evt = apst_word->rec.log_evt;
+        apst_data->log_value = apst_word->rec.log_value;
+        apst_data->log_type = apst_word->rec.log_type;
+        apst_data->clc_flag = (apst_word->rec.log_type == TYPE_TAIL_LOG);
+    }
 }
 
 /**
- * @fn search_head_log
- * @brief tail로그가 없거나 손실되었을때
- *        일정 offset에서 부터 head로그를 찾아내는 함수
+ * @fn write_log_records
+ * @brief 변환된 로그 word들을 현재 페이지에 한번에 기록하고 페이지 정보를 갱신
+ *        호출전 prepare_log_space로 공간이 확보되어 있어야 함.
  * 
- * @return head_address||error=0
+ * @param p_words: encode_log_word로 변환된 word 배열
+ * @param word_cnt: 기록할 word 개수
+ * 
+ * @return error=1||success=0
  */
-uint16 search_head_log(uint16 offset)
+static uint8 write_log_records(log_addr_t *apst_addr, uint32 *p_words, uint8 word_cnt)
 {
-    log_data_t tmp_log;
-    uint16 tmp_addr;
+    log_word_t word;
+    uint8 i;
 
-    if(offset > FLADDR_LOGDATA_ST) {
-        tmp_addr = offset - 1;
-    }else {
-        tmp_addr = FLADDR_LOGDATA_ED;
+    read_win_valid = FALSE;
+    if (write_flash_burst(apst_addr->offset_addr, p_words, word_cnt)) {
+        //로그 기록 실패
+        return 1;
     }
 
-    while (tmp_addr != offset) {
-        read_flash(tmp_addr, FLOPT_UINT32, &tmp_log);
-
-        //시간데이터로 저장된 로그는 필터링
-        if (tmp_log.log_evt & 0x1F) {
-            //head log인지 판별
-            if(tmp_log.log_type == TYPE_HEAD_LOG) {
-                break;
+    //페이지 헤더에 기록될 로그 정보 및 마지막 로그 시각 갱신
+    for (i = 0; i < word_cnt; i++) {
+        word.data_all = p_words[i];
+        if (is_time_record(&word)) {
+            if (word.time.time_value < apst_addr->last_time) {
+                apst_addr->page_mono = FALSE;
+            }
+            apst_addr->last_time = word.time.time_value;
+        } else if (is_commit_record(&word)) {
+            apst_addr->sess_seq = word.commit.sess_seq;
+        } else if (is_ext_record(&word)) {
+            apst_addr->page_kind |= (1 << TYPE_EXT_LOG);
+            log_commit_cnt++;
+        } else {
+            apst_addr->page_kind |= (1 << word.rec.log_type);
+            if (word.rec.log_type == TYPE_NORMAL_LOG || word.rec.log_type == TYPE_HEAD_LOG) {
+                apst_addr->page_evt |= word.rec.log_evt;
             }
-        }else {
-            tmp_addr--;
-            if(tmp_addr < FLADDR_LOGDATA_ST) {
-                tmp_addr = FLADDR_LOGDATA_ED;
+            apst_addr->last_time += word.rec.delta_t;
+            if (word.rec.log_type == TYPE_HEAD_LOG) {
+                //time record 뒤에 기록된 경우를 위해 head log 위치를 다시 설정
+                apst_addr->head_addr = apst_addr->offset_addr;
+                apst_addr->page_head = ADDR_2_RECORD(apst_addr->offset_addr);
+            } else if (word.rec.log_type == TYPE_TAIL_LOG) {
+                apst_addr->tail_addr = apst_addr->offset_addr;
             }
+            log_commit_cnt++;
         }
+        apst_addr->offset_addr++;
     }
-    
-    if(tmp_addr == offset) {
-        //not found head log address
-        return 0;
-    }
+    apst_addr->page_cnt += word_cnt;
 
-    return tmp_addr;
+    apst_addr->offset_addr = ring_wrap_addr(apst_addr, apst_addr->offset_addr);
+
+    return 0;
 }
 
 /**
- * @fn clac_number_of_LogDatas
- * @brief 현재 로그의 head주소와 tail주소를 이용하여 로그개수를 계산
+ * @fn prepare_log_space
+ * @brief offset_addr 위치에 need개의 word를 기록할 수 있도록 준비
+ *        페이지 끝에 도달했다면 현재 페이지를 닫고 다음 페이지를 열어줌.
+ *        공간이 부족하면 남은 word들을 time record로 채워
+ *        페이지 안에 빈 word가 남지 않도록 함.
  * 
- * @todo 버그가 있는 함수이므로 테스트 및 수정을 요구함
+ * @param time: 기록할 로그의 시각, 새 페이지의 base time으로 사용
+ * 
+ * @return error=1||success=0
  */
-uint16 calc_number_of_LogDatas(log_addr_t ast_addr)
+static uint8 prepare_log_space(log_addr_t *apst_addr, uint8 need, uint32 time)
 {
-    uint16 log_cnt = 0;
+    uint32 pads[LOG_COMMIT_WORDS];
+    log_word_t pad;
+    uint16 record = ADDR_2_RECORD(apst_addr->offset_addr);
+    uint8 i;
 
-    if (ast_addr.head_addr > ast_addr.tail_addr) {
-        //Log address after ring buffer rotation
-        log_cnt = FLADDR_LOGDATA_ED - ast_addr.head_addr;
-        log_cnt += ast_addr.tail_addr - FLADDR_LOGDATA_ST;
-    } else if (ast_addr.tail_addr > ast_addr.head_addr) {
-        log_cnt = ast_addr.tail_addr - ast_addr.head_addr;
+    if (record != 0 && record + need <= PG_END_OFFSET + 1) {
+        //현재 페이지에 기록 가능
+        return 0;
     }
 
-    if(log_cnt > 1) {
-        return log_cnt/2;
+    if (record != 0) {
+        //남은 word(need - 1개 이하)는 time record로 채우고 다음 페이지로 넘김
+        pad.data_all = 0;
+        pad.time.time_value = time;
+        pad.time.log_type = TYPE_TIME_LOG;
+        for (i = 0; record + i <= PG_END_OFFSET; i++) {
+            pads[i] = pad.data_all;
+        }
+        if (write_log_records(apst_addr, pads, i)) {
+            return 1;
+        }
     }
 
-    return 0;
+    if (apst_addr->page_seq) {
+        //끝까지 사용한 이전 페이지를 닫음
+        close_log_page(apst_addr, prev_log_page(apst_addr, ADDR_2_PAGE(apst_addr->offset_addr)));
+    }
+
+    return open_log_page(apst_addr, time);
 }
 
 /**
- * @fn generate_new_log_address
- * @brief 새로 기록할 로그주소를 생성
+ * @fn write_commit_marker
+ * @brief 현재 위치에 다음 세션 번호의 commit marker를 기록
+ *        tail log 바로 다음 word에 호출되어야 함.
  * 
- * @param apst_addr: log address struct 변수로, 기존 로그주소를 받아서 새 주소로 반환
+ * @return error=1||success=0
  */
-void generate_new_log_address(log_addr_t *apst_addr)
+static uint8 write_commit_marker(log_addr_t *apst_addr)
 {
-    uint32 flash_vals;
+    log_word_t marker;
 
-    //log counter value init
-    apst_addr->log_cnt = 0;
+    marker.data_all = 0;
+    marker.commit.sess_seq = (apst_addr->sess_seq + 1) & LOG_SESS_SEQ_MASK;
+    marker.commit.check = LOG_COMMIT_CHECK(marker.commit.sess_seq);
+    marker.commit.log_type = TYPE_EXT_LOG;
+    marker.commit.ext_type = LOG_EXT_TYPE(LOG_STAT_COMMIT, LOG_ITEM_NONE);
 
-    if (apst_addr->head_addr == 0) {
-        //head log가 저장된 곳이 없을 때(첫 로그)
-        apst_addr->head_addr = FLADDR_LOGDATA_ST;
-    }else {
-        //이전 로그에 의해 head log가 존재할 때.
-        apst_addr->head_addr = LOGADDR_VALIDATION(apst_addr->tail_addr + 1);
-    }
+    return write_log_records(apst_addr, &marker.data_all, 1);
+}
 
-    //tail log address init.
-    apst_addr->tail_addr = 0;
-    //offset address init.
-    apst_addr->offset_addr = apst_addr->head_addr;
+/**
+ * @fn commit_log_session
+ * @brief tail log를 기록한 뒤 commit marker를 마지막으로 기록하여 로그 세션을 종료
+ *        tail log와 commit marker가 같은 페이지에 들어가도록 공간을 먼저 확보함.
+ * 
+ * @return error=1||success=0
+ */
+static uint8 commit_log_session(log_addr_t *apst_addr, log_data_t *apst_tail, time_data_t *apst_times)
+{
+    if (prepare_log_space(apst_addr, LOG_COMMIT_WORDS, apst_times->time_value)) {
+        return 1;
+    }
 
-    read_flash(apst_addr->head_addr, FLOPT_UINT32, &flash_vals);
-    if(flash_vals != EMPTY_FLASH) {
-        //새로 발급 받은 로그주소가 빈 공간이 아닐경우 해당 페이지 초기화
-        init_flash_mems(apst_addr->head_addr);
+    //1단계: tail log
+    if (stored_log_data(apst_addr, apst_tail, apst_times)) {
+        return 1;
     }
 
+    //2단계: commit marker
+    return write_commit_marker(apst_addr);
 }
 
 /**
- * @fn write_tail_log
- * @brief 로그 마지막에 기록될 tail로그를 쓰는 함수
- * 
- * @param ast_flag: tail로그에 기록될 현재 기기 상태정보가 담긴 플레그 집합
- * @param tail_log: 기록할 tail로그 변수
- * 
- * @return error=1||success=0
+ * @fn log_next_addr
+ * @brief ring에서 다음 로그 word의 주소를 반환, 페이지 헤더는 건너뜀
+ *        페이지가 넘어갈때만 헤더를 읽어 페이지 형식에 맞는 첫 로그 위치로 이동
  */
-uint8 wrtie_tail_log(log_addr_t *apst_addr, Control_flag_t ast_flag)
+uint16 log_next_addr(log_addr_t *apst_addr, uint16 addr)
 {
-    log_data_t tail_log;
+    addr = ring_wrap_addr(apst_addr, addr + 1);
 
-    tail_log.log_value = apst_addr->head_addr;
-    tail_log.log_type = TYPE_TAIL_LOG;
-    tail_log.clc_flag = 1;
+    if (ADDR_2_RECORD(addr) == 0) {
+        addr += page_first_rec(ADDR_2_PAGE(addr));
+    }
 
-    tail_log.log_evt = 0;
+    return addr;
+}
 
-    if(ast_flag.abnormal) {
-        tail_log.log_evt |= LOG_HEAD_ABNORMAL;
+/**
+ * @fn log_base_time
+ * @brief addr 위치 로그 직전의 절대 시각을 계산
+ *        이전 time record 또는 페이지 헤더의 base time까지 역순으로 delta_t를 더함.
+ *        head log 앞에는 항상 time record가 있으므로 로그 시작 위치는 한번의 읽기로 끝남.
+ */
+uint32 log_base_time(uint16 addr)
+{
+    log_page_hdr_t page_hdr;
+    log_word_t word;
+    uint32 delta_sum = 0;
+    uint16 first_rec = page_first_rec(ADDR_2_PAGE(addr));
+
+    while (ADDR_2_RECORD(addr) > first_rec) {
+        addr--;
+        word.data_all = read_log_word(addr);
+        if (is_time_record(&word)) {
+            return word.time.time_value + delta_sum;
+        }
+        if (!is_ext_record(&word)) {
+            delta_sum += word.rec.delta_t;
+        }
     }
 
-    if(ast_flag.serv_en) {
-        tail_log.log_evt |= LOG_HEAD_EN_SERV;
-    }else { 
-        tail_log.log_evt |= LOG_HEAD_NO_SERV;
+    read_log_page_hdr(ADDR_2_PAGE(addr), &page_hdr);
+
+    return page_hdr.base_time + delta_sum;
+}
+
+/**
+ * @fn log_read_begin
+ * @brief 전송할 로그의 읽기 위치를 head log로 설정하고 기준 시각을 계산
+ */
+void log_read_begin(log_addr_t *apst_addr)
+{
+    apst_addr->offset_addr = apst_addr->head_addr;
+    apst_addr->read_time = log_base_time(apst_addr->head_addr);
+}
+
+/**
+ * @fn log_read_record
+ * @brief offset_addr 위치의 로그를 읽어 로그 데이터와 절대 시각으로 복원
+ *        time record와 페이지 헤더는 건너뛰며, 읽은 후 offset_addr는 다음 로그를 가리킴.
+ * 
+ * @return error=1(읽을 로그 없음)||success=0
+ */
+uint8 log_read_record(log_addr_t *apst_addr, log_data_t *apst_data, time_data_t *apst_times)
+{
+    log_page_hdr_t page_hdr;
+    log_word_t word;
+    uint8 i;
+
+    for (i = 0; i < LOG_RECORD_MAX_WORDS; i++) {
+        if (ADDR_2_RECORD(apst_addr->offset_addr) <= LOG_PAGE_HDR_SIZE) {
+            //페이지 첫 로그는 헤더의 base time 기준, 첫 로그 위치는 페이지 형식마다 다름
+            read_log_page_hdr(ADDR_2_PAGE(apst_addr->offset_addr), &page_hdr);
+            if (ADDR_2_RECORD(apst_addr->offset_addr) == page_hdr.open.first_rec) {
+                apst_addr->read_time = page_hdr.base_time;
+            }
+        }
+
+        word.data_all = read_log_word(apst_addr->offset_addr);
+        if (!is_time_record(&word)) {
+            break;
+        }
+        apst_addr->read_time = word.time.time_value;
+        apst_addr->offset_addr = log_next_addr(apst_addr, apst_addr->offset_addr);
     }
 
-    if(write_flash(apst_addr->offset_addr, &tail_log.data_all)) {
-        //write error
+    if (word.data_all == EMPTY_FLASH || is_time_record(&word)) {
         return 1;
     }
 
-    apst_addr->offset_addr++;
-    
+    apst_addr->offset_addr = log_next_addr(apst_addr, apst_addr->offset_addr);
+
+    decode_log_word(&word, apst_data, &apst_addr->read_time);
+
+    apst_times->log_evt = LOG_HEAD_TIME;
+    apst_times->time_value = apst_addr->read_time;
+
+    //다음 로그 앞의 time record는 미리 반영하여 offset_addr가 로그를 가리키도록 함
+    for (i = 0; i < LOG_RECORD_MAX_WORDS; i++) {
+        word.data_all = read_log_word(apst_addr->offset_addr);
+        if (!is_time_record(&word)) {
+            break;
+        }
+        apst_addr->read_time = word.time.time_value;
+        apst_addr->offset_addr = log_next_addr(apst_addr, apst_addr->offset_addr);
+    }
+
     return 0;
 }
 
 /**
- * @fn stored_log_data
- * @brief 현재 로그와 로그발생 시각을 플래시에 저장.
+ * @fn log_query_begin
+ * @brief 로그 검색 조건을 설정하고 검색 위치를 처음으로 되돌림
  * 
- * @return error=1||success=0
+ * @param type_mask: LOG_QRY_EVT(LOG_EVT_XXX) | LOG_QRY_KIND(TYPE_XXX_LOG), 모든 로그는 LOG_QRY_ALL
+ * @param t_from, t_to: 검색할 로그 시각 범위(sec), 양 끝 포함
  */
-uint8 stored_log_data(log_addr_t *apst_addr, log_data_t *apst_data, time_data_t *apst_times)
+void log_query_begin(log_query_t *apst_qry, uint16 type_mask, uint32 t_from, uint32 t_to)
 {
-    uint32 tmp_flash;
-    uint16 offset_addr;
+    apst_qry->type_mask = type_mask;
+    apst_qry->t_from = t_from;
+    apst_qry->t_to = t_to;
 
-    offset_addr = LOGADDR_VALIDATION(apst_addr->offset_addr + 2);
+    apst_qry->cursor = 0;
+    apst_qry->page_seq = 0;
+    apst_qry->page = 0;
+    apst_qry->read_time = 0;
+    apst_qry->match_cnt = 0;
+}
 
-    //사용할 플레시의 페이지 넘김을 체크 
-    if ((offset_addr & PG_END_OFFSET) <= 1) {
-        //새 페이지 플레시 초기화
-        HalFlashErase(ADDR_2_PAGE(offset_addr));
+/**
+ * @fn query_page_match
+ * @brief 페이지 헤더의 index word만으로 검색 조건에 맞는 로그가 있을 수 있는지 확인
+ *        index가 기록되지 않은 페이지(열린 페이지, 닫는 도중 전원 차단)는 모든 bit가 1이므로 항상 검색함.
+ */
+static uint8 query_page_match(log_page_hdr_t *apst_hdr, log_query_t *apst_qry)
+{
+    if (!LOG_PAGE_HAS_INDEX(apst_hdr->open.version)) {
+        return TRUE;
     }
 
-    write_flash(apst_addr->offset_addr, &(apst_data->data_all));
-    read_flash(apst_addr->offset_addr, FLOPT_UINT32, &tmp_flash);
-    if (apst_data->data_all != tmp_flash) {
-        //로그 기록 실패
-        return 1;
+    //시간 범위를 알 수 없는 페이지는 재부팅으로 base time보다 이전 시각의 로그가 있을 수 있음
+    if (apst_hdr->index.span != LOG_SPAN_UNKNOWN &&
+        (apst_hdr->base_time > apst_qry->t_to ||
+         apst_hdr->base_time + apst_hdr->index.span < apst_qry->t_from)) {
+        return FALSE;
     }
 
-    apst_addr->offset_addr = LOGADDR_VALIDATION(apst_addr->offset_addr + 1);
+    return ((apst_hdr->index.kind_mask & (apst_qry->type_mask >> 8)) ||
+            (apst_hdr->index.evt_mask & LOG_QRY_EVT(apst_qry->type_mask)));
+}
+
+/**
+ * @fn query_record_match
+ * @brief 읽어들인 로그가 검색 조건에 맞는지 확인
+ */
+static uint8 query_record_match(log_data_t *apst_data, uint32 time, log_query_t *apst_qry)
+{
+    if (time < apst_qry->t_from || time > apst_qry->t_to) {
+        return FALSE;
+    }
 
-    write_flash(apst_addr->offset_addr, &(apst_times->data_all));
-    read_flash(apst_addr->offset_addr, FLOPT_UINT32, &tmp_flash);
-    if(apst_times->data_all != tmp_flash) {
-        //시간 기록 실패
-        return 1;
+    if (LOG_QRY_KIND(apst_data->log_type) & apst_qry->type_mask) {
+        return TRUE;
     }
 
-    apst_addr->offset_addr = LOGADDR_VALIDATION(apst_addr->offset_addr + 1);
+    return ((apst_data->log_type == TYPE_NORMAL_LOG || apst_data->log_type == TYPE_HEAD_LOG) &&
+            (apst_data->log_evt & LOG_QRY_EVT(apst_qry->type_mask)));
+}
 
-    //log write success, log data init
-    apst_data->data_all = 0;
+/**
+ * @fn query_enter_page
+ * @brief pg부터 sequence가 이어지는 페이지들 중 조건에 맞을 수 있는 첫 페이지로 검색 위치를 옮김
+ *        조건에 맞지 않는 페이지는 헤더만 읽고 로그는 읽지 않음.
+ * 
+ * @param seq: pg 페이지에 기대하는 sequence
+ * 
+ * @return 검색할 페이지 있음=TRUE||검색 종료=FALSE
+ */
+static uint8 query_enter_page(log_addr_t *apst_addr, log_query_t *apst_qry, uint8 pg, uint16 seq)
+{
+    log_page_hdr_t page_hdr;
+    uint8 i;
 
-    return 0;
+    for (i = apst_addr->pg_st; i <= apst_addr->pg_ed; i++, pg = next_log_page(apst_addr, pg), seq++) {
+        read_log_page_hdr(pg, &page_hdr);
+        if (!valid_log_page(&page_hdr) || page_hdr.open.seq != seq) {
+            return FALSE;
+        }
+
+        if (query_page_match(&page_hdr, apst_qry)) {
+            apst_qry->page = pg;
+            apst_qry->page_seq = seq;
+            apst_qry->cursor = PAGE_2_ADDR(pg) + page_hdr.open.first_rec;
+            apst_qry->read_time = page_hdr.base_time;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @fn query_oldest_page
+ * @brief ring에서 현재 페이지부터 sequence가 이어지는 가장 오래된 페이지를 찾음
+ * 
+ * @return page_number||로그 없음=0
+ */
+static uint8 query_oldest_page(log_addr_t *apst_addr, uint16 *p_seq)
+{
+    log_page_hdr_t page_hdr;
+    uint8 pg, oldest = 0;
+    uint8 i;
+
+    if (!apst_addr->page_seq) {
+        return 0;
+    }
+
+    for (pg = apst_addr->pg_st; pg <= apst_addr->pg_ed; pg++) {
+        read_log_page_hdr(pg, &page_hdr);
+        if (valid_log_page(&page_hdr) && page_hdr.open.seq == apst_addr->page_seq) {
+            oldest = pg;
+            break;
+        }
+    }
+    if (!oldest) {
+        return 0;
+    }
+
+    *p_seq = apst_addr->page_seq;
+    for (i = apst_addr->pg_st; i < apst_addr->pg_ed; i++) {
+        pg = prev_log_page(apst_addr, oldest);
+        read_log_page_hdr(pg, &page_hdr);
+        if (!valid_log_page(&page_hdr) || page_hdr.open.seq != (uint16)(*p_seq - 1)) {
+            break;
+        }
+        oldest = pg;
+        (*p_seq)--;
+    }
+
+    return oldest;
+}
+
+/**
+ * @fn log_query
+ * @brief ring에서 검색 조건에 맞는 다음 로그를 찾아 로그 데이터와 절대 시각으로 복원
+ *        오래된 로그부터 순서대로 찾으며 찾은 후 cursor는 다음 로그를 가리킴.
+ *        검색중 cursor 페이지가 지워지고 다시 사용되었다면 검색을 종료함.
+ * 
+ * @return 찾은 로그 있음=0||검색 종료=1
+ */
+uint8 log_query(log_addr_t *apst_addr, log_query_t *apst_qry, log_data_t *apst_data, time_data_t *apst_times)
+{
+    log_page_hdr_t page_hdr;
+    log_word_t word;
+    uint16 seq;
+    uint8 pg;
+
+    if (!apst_qry->cursor) {
+        pg = query_oldest_page(apst_addr, &seq);
+        if (!pg || !query_enter_page(apst_addr, apst_qry, pg, seq)) {
+            return 1;
+        }
+    } else {
+        read_log_page_hdr(apst_qry->page, &page_hdr);
+        if (!valid_log_page(&page_hdr) || page_hdr.open.seq != apst_qry->page_seq) {
+            return 1;
+        }
+    }
+
+    while (1) {
+        word.data_all = EMPTY_FLASH;
+        if (ADDR_2_PAGE(apst_qry->cursor) == apst_qry->page) {
+            word.data_all = read_log_word(apst_qry->cursor);
+        }
+
+        if (word.data_all == EMPTY_FLASH) {
+            //페이지의 끝, 다음 sequence의 페이지로 이동
+            if (!query_enter_page(apst_addr, apst_qry, next_log_page(apst_addr, apst_qry->page),
+                                  apst_qry->page_seq + 1)) {
+                return 1;
+            }
+            continue;
+        }
+        apst_qry->cursor++;
+
+        if (is_time_record(&word)) {
+            apst_qry->read_time = word.time.time_value;
+            continue;
+        } else if (is_commit_record(&word)) {
+            continue;
+        }
+        decode_log_word(&word, apst_data, &apst_qry->read_time);
+
+        if (query_record_match(apst_data, apst_qry->read_time, apst_qry)) {
+            apst_times->log_evt = LOG_HEAD_TIME;
+            apst_times->time_value = apst_qry->read_time;
+            apst_qry->match_cnt++;
+            return 0;
+        }
+    }
+}
+
+/**
+ * @fn last_record_addr
+ * @brief 페이지의 boundary 이전에서 마지막 로그(time record 제외)의 주소를 반환
+ *        끝까지 채우지 않고 닫힌 이전 형식의 페이지를 위해 비어있는 word도 건너뜀
+ * 
+ * @return record_address||없음=0
+ */
+static uint16 last_record_addr(uint8 pg, uint16 first_rec, uint16 boundary)
+{
+    log_word_t word;
+
+    while (boundary > first_rec) {
+        boundary--;
+        word.data_all = read_log_word(PAGE_2_ADDR(pg) + boundary);
+        if (!is_time_record(&word) && word.data_all != EMPTY_FLASH) {
+            return PAGE_2_ADDR(pg) + boundary;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @fn page_last_head
+ * @brief 페이지의 boundary 이전에서 마지막 head log를 역순 탐색
+ * 
+ * @return head_address||없음=0
+ */
+static uint16 page_last_head(uint8 pg, uint16 first_rec, uint16 boundary)
+{
+    log_word_t word;
+
+    while (boundary > first_rec) {
+        boundary--;
+        word.data_all = read_log_word(PAGE_2_ADDR(pg) + boundary);
+        if (!is_ext_record(&word) && word.rec.log_type == TYPE_HEAD_LOG) {
+            return PAGE_2_ADDR(pg) + boundary;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @fn search_open_page_head
+ * @brief 종료되지 않은 로그(tail log 없음)의 head log 위치 탐색
+ *        열린 페이지 안에서만 역순으로 탐색하고, 이전 페이지들은 헤더의
+ *        last_head 값만 확인하므로 페이지당 한번의 읽기로 끝남.
+ * 
+ * @return head_address||error=0
+ */
+static uint16 search_open_page_head(log_addr_t *apst_addr, uint8 pg, uint16 first_rec, uint16 boundary)
+{
+    log_page_hdr_t page_hdr;
+    uint16 head_addr;
+    uint16 seq;
+    uint8 i;
+
+    //열린 페이지의 마지막 로그부터 역순 탐색
+    head_addr = page_last_head(pg, first_rec, boundary);
+    if (head_addr) {
+        return head_addr;
+    }
+
+    //닫힌 페이지는 헤더의 last_head로 판별
+    read_log_page_hdr(pg, &page_hdr);
+    seq = page_hdr.open.seq;
+    for (i = apst_addr->pg_st; i < apst_addr->pg_ed; i++) {
+        pg = prev_log_page(apst_addr, pg);
+        read_log_page_hdr(pg, &page_hdr);
+
+        //연속된 sequence가 아니면 더 오래된 로그이므로 탐색 종료
+        if (!valid_log_page(&page_hdr) || page_hdr.open.seq != --seq) {
+            break;
+        }
+
+        //닫는 도중 전원이 차단되어 close word가 없는 페이지는 직접 탐색
+        if (log_page_open(&page_hdr)) {
+            head_addr = page_last_head(pg, page_hdr.open.first_rec, PG_END_OFFSET + 1);
+            if (head_addr) {
+                return head_addr;
+            }
+        } else if (page_hdr.close.last_head != NO_HEAD_OFFSET) {
+            return PAGE_2_ADDR(pg) + page_hdr.close.last_head;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @fn last_commit_seq
+ * @brief 페이지에서 마지막으로 commit된 세션 번호를 찾음
+ *        페이지 안에 commit marker가 없다면 페이지를 열때 헤더에 기록된 값을 사용함.
+ */
+static uint16 last_commit_seq(uint8 pg, log_page_hdr_t *apst_hdr, uint16 boundary)
+{
+    log_word_t word;
+
+    while (boundary > apst_hdr->open.first_rec) {
+        boundary--;
+        word.data_all = read_log_word(PAGE_2_ADDR(pg) + boundary);
+        if (is_commit_record(&word)) {
+            return word.commit.sess_seq;
+        }
+    }
+
+    return apst_hdr->close.sess_seq;
+}
+
+/**
+ * @fn recover_log_addresses
+ * @brief 부팅시 ring의 로그 페이지 헤더들만 읽어서 마지막 로그의 head/tail 주소를 복구
+ *        - 페이지당 헤더 한번, 열린 페이지는 이진탐색으로 기록 끝 위치를 찾음
+ *        - 마지막 word가 commit marker라면 종료된 세션, tail log까지만 있다면 marker를 이어서 기록
+ *        - tail log도 없다면(기록중 전원 차단) abnormal tail log와 marker를 기록하여 닫음
+ *        - 재부팅 후에는 시스템 시각이 0부터 시작하므로 다음 로그는 time record부터 기록됨
+ * 
+ * @return error=1||success=0
+ */
+uint8 recover_log_addresses(log_addr_t *apst_addr)
+{
+    log_page_hdr_t page_hdr, newest_hdr;
+    log_word_t word;
+    log_data_t tmp_log;
+    time_data_t tmp_time;
+    uint8 pg, newest_pg = 0;
+    uint16 boundary;
+    uint16 last_addr, tail_addr;
+
+    for (pg = apst_addr->pg_st; pg <= apst_addr->pg_ed; pg++) {
+        read_log_page_hdr(pg, &page_hdr);
+        if (!valid_log_page(&page_hdr)) {
+            continue;
+        }
+
+        //sequence 값은 순환하므로 차이값의 부호로 최신 페이지 판별
+        if (!newest_pg || (int16)(page_hdr.open.seq - newest_hdr.open.seq) > 0) {
+            newest_hdr = page_hdr;
+            newest_pg = pg;
+        }
+    }
+
+    apst_addr->head_addr = 0;
+    apst_addr->tail_addr = 0;
+    apst_addr->offset_addr = 0;
+    apst_addr->last_time = LOG_TIME_UNKNOWN;
+
+    if (!newest_pg) {
+        //기록된 로그가 없는 상태
+        apst_addr->page_seq = 0;
+        apst_addr->page_cnt = 0;
+        apst_addr->page_head = NO_HEAD_OFFSET;
+        return 0;
+    }
+
+    apst_addr->page_seq = newest_hdr.open.seq;
+
+    //열린 페이지에 이미 기록된 로그들의 index는 알 수 없으므로 모든 검색에 포함되도록 함
+    apst_addr->page_evt = 0xFF;
+    apst_addr->page_kind = 0x0F;
+    apst_addr->page_mono = FALSE;
+
+    if (!log_page_open(&newest_hdr)) {
+        boundary = PG_END_OFFSET + 1;
+        apst_addr->page_cnt = newest_hdr.close.rec_cnt;
+        apst_addr->page_head = newest_hdr.close.last_head;
+    } else {
+        boundary = search_fill_boundary(PAGE_2_ADDR(newest_pg) + newest_hdr.open.first_rec,
+                                        PAGE_2_ADDR(newest_pg) + PG_END_OFFSET);
+        boundary -= PAGE_2_ADDR(newest_pg);
+        apst_addr->page_cnt = boundary - newest_hdr.open.first_rec;
+        apst_addr->page_head = NO_HEAD_OFFSET;
+    }
+
+    apst_addr->sess_seq = last_commit_seq(newest_pg, &newest_hdr, boundary);
+
+    last_addr = last_record_addr(newest_pg, newest_hdr.open.first_rec, boundary);
+    if (!last_addr) {
+        //로그가 없는 열린 페이지, 이전 페이지의 마지막 로그를 확인
+        pg = prev_log_page(apst_addr, newest_pg);
+        read_log_page_hdr(pg, &page_hdr);
+        if (valid_log_page(&page_hdr) && !log_page_open(&page_hdr)) {
+            last_addr = last_record_addr(pg, page_hdr.open.first_rec, PG_END_OFFSET + 1);
+        }
+        if (!last_addr) {
+            apst_addr->offset_addr = ring_wrap_addr(apst_addr, PAGE_2_ADDR(newest_pg) + boundary);
+            return 0;
+        }
+    }
+
+    //commit marker는 tail log와 같은 페이지에 기록되므로 마지막 word만으로 세션 종료 여부 판단
+    word.data_all = read_log_word(last_addr);
+    tail_addr = is_commit_record(&word) ? last_addr - 1 : last_addr;
+    word.data_all = read_log_word(tail_addr);
+
+    if (word.rec.log_type == TYPE_TAIL_LOG && word.rec.log_evt & 0x1F) {
+        apst_addr->tail_addr = tail_addr;
+        apst_addr->head_addr = word.rec.log_value;
+
+        if (ADDR_2_PAGE(apst_addr->head_addr) == newest_pg) {
+            apst_addr->page_head = ADDR_2_RECORD(apst_addr->head_addr);
+        }
+
+        //tail log 기록 후 commit marker 기록 전에 중단된 세션은 marker를 이어서 기록
+        if (tail_addr == last_addr && tail_addr + 1 == PAGE_2_ADDR(newest_pg) + boundary &&
+            ADDR_2_RECORD(tail_addr) < PG_END_OFFSET) {
+            apst_addr->offset_addr = tail_addr + 1;
+            write_commit_marker(apst_addr);
+            apst_addr->offset_addr = 0;
+        }
+        return 0;
+    }
+
+    //tail log가 없는 로그, head log를 찾아 tail log를 기록하여 로그를 닫음
+    apst_addr->head_addr = search_open_page_head(apst_addr, newest_pg, newest_hdr.open.first_rec, boundary);
+    if (!apst_addr->head_addr) {
+        return 1;
+    }
+
+    if (ADDR_2_PAGE(apst_addr->head_addr) == newest_pg) {
+        apst_addr->page_head = ADDR_2_RECORD(apst_addr->head_addr);
+    }
+    apst_addr->offset_addr = ring_wrap_addr(apst_addr, PAGE_2_ADDR(newest_pg) + boundary);
+
+    tmp_log.data_all = 0;
+    tmp_log.log_evt = LOG_HEAD_ABNORMAL;
+    tmp_log.log_type = TYPE_TAIL_LOG;
+    tmp_log.log_value = apst_addr->head_addr;
+
+    tmp_time.log_evt = LOG_HEAD_TIME;
+    tmp_time.time_value = 0;
+
+    if (commit_log_session(apst_addr, &tmp_log, &tmp_time)) {
+        return 1;
+    }
+    apst_addr->offset_addr = 0;
+
+    return 0;
+}
+
+/**
+ * @fn generate_new_log_address
+ * @brief 새로 기록할 로그주소를 생성
+ * 
+ * @param apst_addr: log address struct 변수로, 기존 로그주소를 받아서 새 주소로 반환
+ * @param time: 새 로그의 첫 로그 시각, 새 페이지를 열게 되면 base time으로 사용
+ */
+void generate_new_log_address(log_addr_t *apst_addr, uint32 time)
+{
+    uint32 flash_val;
+    uint8 i;
+
+    //log counter value init
+    apst_addr->log_cnt = 0;
+
+    if (apst_addr->tail_addr != 0) {
+        //이전 로그에 의해 tail log가 존재할 때, tail log 다음 위치.
+        apst_addr->offset_addr = ring_wrap_addr(apst_addr, apst_addr->tail_addr + LOG_RECORD_SIZE);
+
+        //tail log 뒤의 commit marker와 기록중 끊긴 time record는 건너뜀
+        for (i = 0; i < LOG_COMMIT_WORDS && ADDR_2_RECORD(apst_addr->offset_addr); i++) {
+            flash_val = read_log_word(apst_addr->offset_addr);
+            if (flash_val == EMPTY_FLASH) {
+                break;
+            }
+            apst_addr->offset_addr = ring_wrap_addr(apst_addr, apst_addr->offset_addr + 1);
+        }
+    } else if (!ring_addr_valid(apst_addr, apst_addr->offset_addr)) {
+        //tail log가 저장된 곳이 없을 때(첫 로그), 가장 적게 지워진 페이지부터 시작
+        apst_addr->offset_addr = PAGE_2_ADDR(least_worn_log_page(apst_addr));
+    }
+
+    if (ADDR_2_RECORD(apst_addr->offset_addr) &&
+        page_first_rec(ADDR_2_PAGE(apst_addr->offset_addr)) != LOG_PAGE_HDR_SIZE) {
+        //이전 형식의 페이지에는 이어서 기록하지 않음, 다음 페이지를 열면서 이전 페이지를 닫음
+        apst_addr->offset_addr = ring_wrap_addr(apst_addr, (apst_addr->offset_addr & ~PG_END_OFFSET) + PG_END_OFFSET + 1);
+    }
+
+    //새 로그주소가 페이지 경계라면 새 페이지를 열어줌
+    prepare_log_space(apst_addr, LOG_RECORD_MAX_WORDS, time);
+
+    apst_addr->head_addr = apst_addr->offset_addr;
+
+    //tail log address init.
+    apst_addr->tail_addr = 0;
+}
+
+/**
+ * @fn write_tail_log
+ * @brief 로그 마지막에 기록될 tail로그를 쓰는 함수
+ * 
+ * @param ast_flag: tail로그에 기록될 현재 기기 상태정보가 담긴 플레그 집합
+ * @param apst_times: tail로그와 함께 기록될 로그 종료 시각
+ * 
+ * @return error=1||success=0
+ */
+uint8 wrtie_tail_log(log_addr_t *apst_addr, Control_flag_t ast_flag, time_data_t *apst_times)
+{
+    log_data_t tail_log;
+
+    tail_log.data_all = 0;
+    tail_log.log_value = apst_addr->head_addr;
+    tail_log.log_type = TYPE_TAIL_LOG;
+    tail_log.clc_flag = 1;
+
+    tail_log.log_evt = 0;
+
+    if(ast_flag.abnormal) {
+        tail_log.log_evt |= LOG_HEAD_ABNORMAL;
+    }
+
+    if(ast_flag.serv_en) {
+        tail_log.log_evt |= LOG_HEAD_EN_SERV;
+    }else {
+        tail_log.log_evt |= LOG_HEAD_NO_SERV;
+    }
+
+    return commit_log_session(apst_addr, &tail_log, apst_times);
+}
+
+/**
+ * @fn log_session_close
+ * @brief RAM 버퍼의 로그를 모두 기록한 뒤 진행중인 로그 세션을 tail log와 commit marker로 종료
+ *        진행중인 세션이 없다면 아무것도 기록하지 않음.
+ * 
+ * @return error=1||success=0
+ */
+uint8 log_session_close(log_addr_t *apst_addr, Control_flag_t ast_flag, time_data_t *apst_times)
+{
+    if (log_stage_flush(apst_addr, LOG_STAGE_SIZE)) {
+        return 1;
+    }
+
+    if (!ring_addr_valid(apst_addr, apst_addr->head_addr) || apst_addr->tail_addr) {
+        return 0;
+    }
+
+    return wrtie_tail_log(apst_addr, ast_flag, apst_times);
+}
+
+/**
+ * @fn stored_log_data
+ * @brief 현재 로그와 로그발생 시각을 플래시에 저장.
+ *        필요한 경우 time record와 로그를 한번에 기록함.
+ * 
+ * @return error=1||success=0
+ */
+uint8 stored_log_data(log_addr_t *apst_addr, log_data_t *apst_data, time_data_t *apst_times)
+{
+    uint32 words[LOG_RECORD_MAX_WORDS];
+    uint8 need;
+
+    need = log_word_need(apst_data->log_type, apst_times->time_value, apst_addr->last_time,
+                         ADDR_2_RECORD(apst_addr->offset_addr) == LOG_PAGE_HDR_SIZE);
+
+    //페이지 넘김 체크, 새 페이지라면 페이지 헤더 기록
+    if (prepare_log_space(apst_addr, need, apst_times->time_value)) {
+        return 1;
+    }
+
+    //새 페이지가 열렸다면 base time 기준으로 다시 계산
+    need = log_word_need(apst_data->log_type, apst_times->time_value, apst_addr->last_time,
+                         ADDR_2_RECORD(apst_addr->offset_addr) == LOG_PAGE_HDR_SIZE);
+    encode_log_word(apst_data, apst_times->time_value, apst_addr->last_time, need, words);
+
+    if (write_log_records(apst_addr, words, need)) {
+        return 1;
+    }
+
+    //log write success, log data init
+    apst_data->data_all = 0;
+
+    return 0;
+}
+
+/**
+ * @fn log_event_store
+ * @brief 이상 이벤트 1개를 이벤트 ring에 하나의 로그 세션으로 즉시 기록
+ *        이벤트를 head log로, abnormal tail log와 commit marker로 세션을 바로 닫으므로
+ *        기록 직후 전원이 차단되어도 복구 과정 없이 보존됨.
+ * 
+ * @return error=1||success=0
+ */
+uint8 log_event_store(log_addr_t *apst_addr, log_data_t *apst_data, time_data_t *apst_times)
+{
+    log_data_t evt_log;
+
+    generate_new_log_address(apst_addr, apst_times->time_value);
+
+    evt_log.data_all = apst_data->data_all;
+    evt_log.log_type = TYPE_HEAD_LOG;
+    if (stored_log_data(apst_addr, &evt_log, apst_times)) {
+        return 1;
+    }
+
+    evt_log.data_all = 0;
+    evt_log.log_evt = LOG_HEAD_ABNORMAL;
+    evt_log.log_value = apst_addr->head_addr;
+    evt_log.log_type = TYPE_TAIL_LOG;
+    evt_log.clc_flag = 1;
+
+    return commit_log_session(apst_addr, &evt_log, apst_times);
+}
+
+/**
+ * @fn log_stage_push
+ * @brief 로그를 플래시에 바로 쓰지 않고 ring의 RAM 버퍼에 쌓아둠
+ *        버퍼가 가득 찼다면 가장 오래된 로그들을 먼저 플래시에 기록
+ * 
+ * @return error=1||success=0
+ */
+uint8 log_stage_push(log_addr_t *apst_addr, log_data_t *apst_data, time_data_t *apst_times)
+{
+    log_stage_t *p_stage = &log_stage[apst_addr->ring];
+
+    if (p_stage->cnt >= LOG_STAGE_SIZE) {
+        log_stage_flush(apst_addr, LOG_FLUSH_BURST);
+        if (p_stage->cnt >= LOG_STAGE_SIZE) {
+            return 1;
+        }
+    }
+
+    p_stage->log[p_stage->head] = apst_data->data_all;
+    p_stage->time[p_stage->head] = apst_times->time_value;
+    p_stage->head = (p_stage->head + 1) % LOG_STAGE_SIZE;
+    p_stage->cnt++;
+
+    //log staged, log data init
+    apst_data->data_all = 0;
+
+    return 0;
+}
+
+/**
+ * @fn log_stage_count
+ * @brief ring의 RAM 버퍼에 남아있는 로그 개수
+ */
+uint8 log_stage_count(log_addr_t *apst_addr)
+{
+    return log_stage[apst_addr->ring].cnt;
+}
+
+/**
+ * @fn log_stage_flush
+ * @brief ring의 RAM 버퍼 로그를 오래된 순서로 최대 max_cnt개 플래시에 기록
+ *        같은 페이지에 들어가는 로그들은 1word 형식으로 변환하여 write_flash_burst로 묶어서 기록함.
+ *        진행중인 로그가 없다면 새 로그를 시작하고 첫 로그를 head log로 기록.
+ * 
+ * @return 버퍼에 남은 로그 개수
+ */
+uint8 log_stage_flush(log_addr_t *apst_addr, uint8 max_cnt)
+{
+    log_data_t tmp_log;
+    time_data_t tmp_time;
+    uint32 words[FLASH_BURST_MAX];
+    uint32 last_time;
+    uint16 room;
+    uint8 word_cnt, rec_cnt;
+    uint8 need, idx;
+    log_stage_t *p_stage = &log_stage[apst_addr->ring];
+
+    while (p_stage->cnt && max_cnt) {
+        if (!ring_addr_valid(apst_addr, apst_addr->head_addr) || apst_addr->tail_addr) {
+            //종료된 로그 뒤에 새 로그 시작
+            generate_new_log_address(apst_addr, p_stage->time[p_stage->tail]);
+
+            tmp_log.data_all = p_stage->log[p_stage->tail];
+            if (tmp_log.log_type == TYPE_EXT_LOG) {
+                //텔레메트리로 시작하는 로그는 빈 head log를 먼저 기록
+                tmp_log.data_all = 0;
+                tmp_log.log_type = TYPE_HEAD_LOG;
+                tmp_time.log_evt = LOG_HEAD_TIME;
+                tmp_time.time_value = p_stage->time[p_stage->tail];
+                if (stored_log_data(apst_addr, &tmp_log, &tmp_time)) {
+                    break;
+                }
+            } else {
+                tmp_log.log_type = TYPE_HEAD_LOG;
+                p_stage->log[p_stage->tail] = tmp_log.data_all;
+            }
+        }
+
+        tmp_log.data_all = p_stage->log[p_stage->tail];
+        need = log_word_need(tmp_log.log_type, p_stage->time[p_stage->tail], apst_addr->last_time,
+                             ADDR_2_RECORD(apst_addr->offset_addr) == LOG_PAGE_HDR_SIZE);
+        if (prepare_log_space(apst_addr, need, p_stage->time[p_stage->tail])) {
+            break;
+        }
+
+        //현재 페이지와 버스트 크기를 넘지 않는 만큼 변환하여 묶어서 기록
+        room = PG_END_OFFSET + 1 - ADDR_2_RECORD(apst_addr->offset_addr);
+        if (room > FLASH_BURST_MAX) {
+            room = FLASH_BURST_MAX;
+        }
+
+        last_time = apst_addr->last_time;
+        word_cnt = 0;
+        rec_cnt = 0;
+        idx = p_stage->tail;
+        while (rec_cnt < p_stage->cnt && rec_cnt < max_cnt) {
+            tmp_log.data_all = p_stage->log[idx];
+            need = log_word_need(tmp_log.log_type, p_stage->time[idx], last_time,
+                                 !word_cnt && ADDR_2_RECORD(apst_addr->offset_addr) == LOG_PAGE_HDR_SIZE);
+            if (word_cnt + need > room) {
+                break;
+            }
+
+            encode_log_word(&tmp_log, p_stage->time[idx], last_time, need, &words[word_cnt]);
+            last_time = p_stage->time[idx];
+            word_cnt += need;
+            rec_cnt++;
+            idx = (idx + 1) % LOG_STAGE_SIZE;
+        }
+
+        if (!rec_cnt || write_log_records(apst_addr, words, word_cnt)) {
+            break;
+        }
+
+        p_stage->tail = idx;
+        p_stage->cnt -= rec_cnt;
+        max_cnt -= rec_cnt;
+    }
+
+    return p_stage->cnt;
+}
+
+/**
+ * @fn get_log_write_stats
+ * @brief 기록 완료된 로그 개수와 플래시 쓰기 횟수를 반환
+ *        write_cycles / records 로 로그 1개당 플래시 쓰기 횟수를 확인
+ */
+void get_log_write_stats(uint32 *records, uint32 *write_cycles)
+{
+    flash_stats_t flash_stats;
+
+    get_flash_stats(&flash_stats);
+
+    *records = log_commit_cnt;
+    *write_cycles = flash_stats.write_cycles;
+}
+
+/**
+ * @fn log_pre_erase
+ * @brief ring에서 다음에 사용할 로그페이지 LOG_PRE_ERASE_CNT개를 미리 지워둠
+ *        한번 호출에 최대 한 페이지만 지우므로 이벤트 처리 시간이 페이지 지우기 1회로 제한됨.
+ * 
+ * @return 아직 지워야 할 페이지가 남아있으면 1, 모두 준비되었다면 0
+ */
+uint8 log_pre_erase(log_addr_t *apst_addr)
+{
+    uint8 pg, pg_idx;
+    uint8 i;
+
+    //다음에 열릴 페이지 계산
+    if (ring_addr_valid(apst_addr, apst_addr->offset_addr)) {
+        pg = ADDR_2_PAGE(apst_addr->offset_addr);
+        if (ADDR_2_RECORD(apst_addr->offset_addr) != 0) {
+            pg = next_log_page(apst_addr, pg);
+        }
+    } else if (ring_addr_valid(apst_addr, apst_addr->tail_addr)) {
+        pg = next_log_page(apst_addr, ADDR_2_PAGE(apst_addr->tail_addr));
+    } else if (apst_addr->page_seq == 0) {
+        pg = least_worn_log_page(apst_addr);
+    } else {
+        //기록 위치를 알 수 없는 상태
+        return 0;
+    }
+
+    for (i = 0; i < LOG_PRE_ERASE_CNT; i++, pg = next_log_page(apst_addr, pg)) {
+        pg_idx = pg - LOG_PAGE_ST;
+        if (pre_erased[pg_idx >> 3] & (1 << (pg_idx & 0x07))) {
+            continue;
+        }
+
+        //이미 비어있는 페이지는 지우지 않고 bitmap에만 표시
+        if (!log_page_blank(pg)) {
+            log_page_erase(apst_addr, pg);
+            read_win_valid = FALSE;
+            pre_erased[pg_idx >> 3] |= (1 << (pg_idx & 0x07));
+            return (i + 1 < LOG_PRE_ERASE_CNT);
+        }
+        pre_erased[pg_idx >> 3] |= (1 << (pg_idx & 0x07));
+    }
+
+    return 0;
+}
+
+/**
+ * @fn get_log_erase_stats
+ * @brief 미리 지워둔 덕분에 생략된 페이지 지우기와 기록중 발생한 페이지 지우기 횟수
+ */
+void get_log_erase_stats(uint16 *avoided, uint16 *inline_cnt)
+{
+    *avoided = erase_avoided_cnt;
+    *inline_cnt = erase_inline_cnt;
+}
+
+/**
+ * @fn log_aggr_reset
+ * @brief 집계 윈도우의 통계값 초기화
+ */
+static void log_aggr_reset(log_aggr_t *apst_aggr)
+{
+    uint8 i;
+
+    for (i = 0; i < LOG_AGGR_CH_CNT; i++) {
+        apst_aggr->ch[i].min = 0x7FFF;
+        apst_aggr->ch[i].max = -0x7FFF;
+        apst_aggr->ch[i].sum = 0;
+    }
+    apst_aggr->cnt = 0;
+}
+
+/**
+ * @fn log_aggr_init
+ * @brief 충전 텔레메트리 집계 초기화, 충전 시작시 호출
+ * 
+ * @param window: 요약 record 1개로 묶을 샘플 개수
+ */
+void log_aggr_init(log_aggr_t *apst_aggr, uint16 window)
+{
+    apst_aggr->window = window;
+    apst_aggr->raw_valid = FALSE;
+
+    apst_aggr->ch[LOG_ITEM_VOLT - 1].delta = LOG_AGGR_DELTA_VOLT;
+    apst_aggr->ch[LOG_ITEM_CURR - 1].delta = LOG_AGGR_DELTA_CURR;
+    apst_aggr->ch[LOG_ITEM_TEMP - 1].delta = LOG_AGGR_DELTA_TEMP;
+
+    log_aggr_reset(apst_aggr);
+}
+
+/**
+ * @fn log_aggr_set_delta
+ * @brief 항목별 raw 기록 임계값 변경
+ * 
+ * @param item: LOG_ITEM_XXX
+ */
+void log_aggr_set_delta(log_aggr_t *apst_aggr, uint8 item, int16 delta)
+{
+    if (item == LOG_ITEM_NONE || item > LOG_AGGR_CH_CNT) {
+        return;
+    }
+    apst_aggr->ch[item - 1].delta = delta;
+}
+
+/**
+ * @fn log_aggr_push
+ * @brief 텔레메트리 record 1개를 RAM 버퍼에 추가
+ */
+static uint8 log_aggr_push(log_addr_t *apst_addr, uint8 stat, uint8 item, int16 value, uint32 time)
+{
+    log_data_t ext_log;
+    time_data_t ext_time;
+
+    ext_log.data_all = 0;
+    ext_log.log_evt = stat;
+    ext_log.log_value = (uint16)value;
+    ext_log.log_type = TYPE_EXT_LOG;
+    ext_log.data_type = item;
+
+    ext_time.log_evt = LOG_HEAD_TIME;
+    ext_time.time_value = time;
+
+    return log_stage_push(apst_addr, &ext_log, &ext_time);
+}
+
+/**
+ * @fn log_aggr_summary
+ * @brief 현재까지 집계된 윈도우를 요약 record로 기록하고 통계 초기화
+ * 
+ * @return error=1||success=0
+ */
+static uint8 log_aggr_summary(log_addr_t *apst_addr, log_aggr_t *apst_aggr, uint32 time)
+{
+    log_aggr_ch_t *p_ch;
+    uint8 i;
+    uint8 err = 0;
+
+    if (!apst_aggr->cnt) {
+        return 0;
+    }
+
+    for (i = 0; i < LOG_AGGR_CH_CNT; i++) {
+        p_ch = &apst_aggr->ch[i];
+        err |= log_aggr_push(apst_addr, LOG_STAT_MIN, i + 1, p_ch->min, time);
+        err |= log_aggr_push(apst_addr, LOG_STAT_MAX, i + 1, p_ch->max, time);
+        err |= log_aggr_push(apst_addr, LOG_STAT_MEAN, i + 1, (int16)(p_ch->sum / apst_aggr->cnt), time);
+    }
+    err |= log_aggr_push(apst_addr, LOG_STAT_CNT, LOG_ITEM_NONE, apst_aggr->cnt, time);
+
+    log_aggr_reset(apst_aggr);
+
+    return err;
+}
+
+/**
+ * @fn log_aggr_sample
+ * @brief 충전중 샘플 1개를 집계, 윈도우가 차면 요약 record를 기록
+ *        직전 raw 기록값과 임계값 이상 차이나는 항목은 raw 값을 바로 기록함.
+ * 
+ * @param p_values: LOG_ITEM_VOLT, LOG_ITEM_CURR, LOG_ITEM_TEMP 순서의 샘플 값
+ * @param time: 샘플 시각(sec)
+ * 
+ * @return error=1||success=0
+ */
+uint8 log_aggr_sample(log_addr_t *apst_addr, log_aggr_t *apst_aggr, int16 *p_values, uint32 time)
+{
+    log_aggr_ch_t *p_ch;
+    int16 diff;
+    uint8 i;
+    uint8 err = 0;
+
+    for (i = 0; i < LOG_AGGR_CH_CNT; i++) {
+        p_ch = &apst_aggr->ch[i];
+
+        if (p_values[i] < p_ch->min) {
+            p_ch->min = p_values[i];
+        }
+        if (p_values[i] > p_ch->max) {
+            p_ch->max = p_values[i];
+        }
+        p_ch->sum += p_values[i];
+
+        //충전 곡선의 변곡점은 raw 값으로 기록
+        diff = p_values[i] - p_ch->last_raw;
+        if (!apst_aggr->raw_valid || diff >= p_ch->delta || -diff >= p_ch->delta) {
+            err |= log_aggr_push(apst_addr, LOG_STAT_RAW, i + 1, p_values[i], time);
+            p_ch->last_raw = p_values[i];
+        }
+    }
+    apst_aggr->raw_valid = TRUE;
+
+    if (++apst_aggr->cnt >= apst_aggr->window) {
+        err |= log_aggr_summary(apst_addr, apst_aggr, time);
+    }
+
+    return err;
+}
+
+/**
+ * @fn log_aggr_flush
+ * @brief 충전 종료시 호출, 남은 샘플을 요약 record로 기록
+ *        다음 충전의 첫 샘플은 raw 값으로 기록되도록 raw 기록값을 무효화함.
+ * 
+ * @return error=1||success=0
+ */
+uint8 log_aggr_flush(log_addr_t *apst_addr, log_aggr_t *apst_aggr, uint32 time)
+{
+    apst_aggr->raw_valid = FALSE;
+
+    return log_aggr_summary(apst_addr, apst_aggr, time);
+}
+
+/**
+ * @fn log_raw_push
+ * @brief 집계하지 않는 항목 값 1개를 raw record로 기록 (PMIC 응답시간 등)
+ *
+ * @return error=1||success=0
+ */
+uint8 log_raw_push(log_addr_t *apst_addr, uint8 item, int16 value, uint32 time)
+{
+    return log_aggr_push(apst_addr, LOG_STAT_RAW, item, value, time);
+}
+
+/**
+ * @fn get_log_wear_histogram
+ * @brief 로그 페이지들의 지우기 횟수 분포를 bins개 구간으로 나누어 반환
+ * 
+ * @param p_hist: 구간별 페이지 개수를 받을 배열 (bins 크기)
+ * @param p_min, p_max: 가장 적게/많이 지워진 페이지의 지우기 횟수
+ */
+void get_log_wear_histogram(uint16 *p_hist, uint8 bins, uint32 *p_min, uint32 *p_max)
+{
+    uint32 erase_cnt, width;
+    uint8 pg, i;
+
+    *p_min = EMPTY_FLASH;
+    *p_max = 0;
+    for (pg = LOG_PAGE_ST; pg <= LOG_PAGE_ED; pg++) {
+        erase_cnt = get_page_wear(pg);
+        if (erase_cnt < *p_min) {
+            *p_min = erase_cnt;
+        }
+        if (erase_cnt > *p_max) {
+            *p_max = erase_cnt;
+        }
+    }
+
+    width = (*p_max - *p_min) / bins + 1;
+    for (i = 0; i < bins; i++) {
+        p_hist[i] = 0;
+    }
+    for (pg = LOG_PAGE_ST; pg <= LOG_PAGE_ED; pg++) {
+        p_hist[(get_page_wear(pg) - *p_min) / width]++;
+    }
 }
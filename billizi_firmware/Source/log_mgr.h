@@ -18,49 +18,302 @@
 #define LOG_EVT_IMPACT    0x10
 #define LOG_EVT_BRK_CABLE 0x20
 #define LOG_EVT_PWR_OFF   0x40
+#define LOG_EVT_EXT_V_LOSS 0x80
 
-//#define TYPE_TIME_LOG   0x00  
+//RAM 버퍼를 거치지 않고 즉시 플래시에 기록해야 하는 이벤트
+#define LOG_EVT_CRITICAL  (LOG_EVT_PWR_OFF | LOG_EVT_OVER_TEMP | LOG_EVT_EXT_V_LOSS)
+//이벤트 ring에 별도로 보관하는 이상 이벤트
+#define LOG_EVT_ABNORMAL  (LOG_EVT_CRITICAL | LOG_EVT_OVER_CURR | LOG_EVT_IMPACT | LOG_EVT_BRK_CABLE)
+
+#define TYPE_EXT_LOG    0x03
 #define TYPE_HEAD_LOG   0x01
 #define TYPE_TAIL_LOG   0x02
 #define TYPE_NORMAL_LOG 0x00
 
+/* extended record (TYPE_EXT_LOG)
+ * 플래시 기록시 ext_type = (stat << 3) | item 으로 세부 종류를 구분함.
+ * time record는 ext_type 0, 충전 텔레메트리는 항목별 통계값/raw값을 가짐.
+ * 로그 데이터(log_data_t)로 읽을때는 log_evt = stat, data_type = item */
+#define TYPE_TIME_LOG   TYPE_EXT_LOG
+#define LOG_EXT_TYPE(stat, item)    (((stat) << 3) | (item))
+
+#define LOG_STAT_TIME   0x0
+#define LOG_STAT_MIN    0x1
+#define LOG_STAT_MAX    0x2
+#define LOG_STAT_MEAN   0x3
+#define LOG_STAT_CNT    0x4
+#define LOG_STAT_RAW    0x5
+#define LOG_STAT_COMMIT 0x6     //로그 세션 commit marker, 세션의 마지막 word
+
+#define LOG_ITEM_NONE   0x0
+#define LOG_ITEM_VOLT   0x1     //배터리 전압 [mV]
+#define LOG_ITEM_CURR   0x2     //충전 전류 [mA]
+#define LOG_ITEM_TEMP   0x3     //온도 [0.1'C]
+#define LOG_ITEM_PMIC   0x4     //케이블 검사 PMIC 응답시간 [ms]
+
 // #define TYPE_TIME_LOG   0x00  
 // #define TYPE_HEAD_LOG   0x01
 // #define TYPE_TAIL_LOG   0x02
 // #define TYPE_NORMAL_LOG 0x04 
 #define TYPE_INVALID_LOG (TYPE_TAIL_LOG | TYPE_HEAD_LOG | TYPE_NORMAL_LOG)
 
-//flash_interface.h 있는 log_data_t를 대체할 스트럭쳐
-//아직 사용하지 않는중..
-typedef struct _NEW_LOGS {
+/* log page header
+ * 로그 영역의 각 페이지 시작 5word는 페이지 헤더로 사용됨. (LOG_PAGE_VERSION 기준)
+ * wear word: 페이지를 지울때 기록 (누적 지우기 횟수, FLASH_WEAR_OFFSET)
+ * open word: 페이지를 열때 기록 (sequence, 첫 로그 위치, 상태, 버전)
+ * base time: 페이지를 열때 기록, 페이지 첫 로그의 절대 시각(sec)
+ * close word: 페이지를 열때 sess_seq만 기록, 닫을때 사용한 word 개수와 마지막 head log 위치 기록
+ * index word: 페이지를 닫을때 기록, 페이지 로그들의 이벤트/종류 bitmap과 시간 범위 (로그 검색용)
+ * 부팅시 각 페이지의 헤더만 읽어 가장 최근 페이지를 찾아냄.
+ *
+ * 페이지 형식은 open word의 version으로 구분되며 record 형식(log_word_t)은 모든 버전이 같음.
+ * 기록(append)은 현재 형식(LOG_PAGE_VERSION)으로만 컴파일되고,
+ * 읽기는 LOG_PAGE_VERSION_MIN 이후 형식의 페이지를 변환 없이 그대로 읽음.
+ * 헤더가 없는 이전 펌웨어의 로그(2word 로그 + key log)는 설정 migration에서 한번 지워지므로 읽지 않음.
+ *   v4: 4word 헤더, index word 없음
+ *   v5: 5word 헤더, index word 추가 */
+#define LOG_PAGE_HDR_SIZE   5
+#define LOG_PAGE_VERSION    0x5
+#define LOG_PAGE_VERSION_MIN 0x4
+#define LOG_PAGE_HAS_INDEX(ver) ((ver) >= 0x5)
+
+#define LOG_HDR_OPEN_WORDS  3       //페이지를 열때 기록하는 word 수 (open, base time, close)
+#define LOG_HDR_CLOSE_OFFSET 3
+#define LOG_HDR_INDEX_OFFSET 4
+
+//index word의 시간 범위를 알 수 없음 (기록되지 않은 index word와 같은 값)
+#define LOG_SPAN_UNKNOWN    0xFFFFF
+
+#define PAGE_ST_ERASED  0x7
+#define PAGE_ST_OPEN    0x3
+#define PAGE_ST_FULL    0x1
+
+#define LOG_PAGE_ST     ADDR_2_PAGE(FLADDR_LOGDATA_ST)
+#define LOG_PAGE_ED     ADDR_2_PAGE(FLADDR_LOGDATA_ED)
+#define LOG_PAGE_CNT    (LOG_PAGE_ED - LOG_PAGE_ST + 1)
+#define NO_HEAD_OFFSET  0       //record 0은 헤더 영역이므로 head log가 올 수 없음
+
+/* log ring
+ * 로그 영역은 스트림별로 독립된 ring으로 나누어 사용됨.
+ * 각 ring은 자신의 페이지 범위 안에서만 순환하며 head/tail, 페이지 sequence, 세션 번호를 따로 가짐.
+ * 충전 텔레메트리가 많이 쌓여도 다른 ring의 로그(특히 이상 이벤트)는 덮어쓰지 않음.
+ * ring 크기는 host_test/log_wear의 ring별 지우기 횟수 측정으로 정함. 기록량 대부분이 충전 텔레메트리이므로
+ * 방전/이벤트 ring에 로그 영역의 1/8씩 두면 외부전압 끊김이 잦은 경우에도 페이지당 지우기 횟수가 비슷함. */
+#define LOG_RING_CHG    0       //충전 텔레메트리
+#define LOG_RING_DISCHG 1       //방전/대여 로그, 키오스크 전송 대상
+#define LOG_RING_EVT    2       //이상 이벤트
+#define LOG_RING_CNT    3
+
+#define LOG_RING_DISCHG_PAGES   (LOG_PAGE_CNT / 8)
+#define LOG_RING_EVT_PAGES      (LOG_PAGE_CNT / 8)
+#define LOG_RING_CHG_PAGES      (LOG_PAGE_CNT - LOG_RING_DISCHG_PAGES - LOG_RING_EVT_PAGES)
+
+#define LOG_RING_CHG_ST     LOG_PAGE_ST
+#define LOG_RING_DISCHG_ST  (LOG_RING_CHG_ST + LOG_RING_CHG_PAGES)
+#define LOG_RING_EVT_ST     (LOG_RING_DISCHG_ST + LOG_RING_DISCHG_PAGES)
+
+/* log record
+ * 로그 1개는 1word로 기록되며 직전 로그와의 시간차(delta_t, sec)를 가짐.
+ * 시간차가 LOG_DELTA_MAX를 넘거나, 시간이 되돌아갔거나(재부팅), head log인 경우
+ * 앞에 절대 시각을 담은 time record(TYPE_TIME_LOG) 1word가 추가로 기록됨.
+ * 페이지의 첫 로그는 헤더의 base time을 기준으로 함. */
+#define LOG_RECORD_SIZE 1
+#define LOG_RECORD_MAX_WORDS 2
+#define LOG_DELTA_MAX   0x3F
+#define LOG_TIME_UNKNOWN 0xFFFFFFFF
+
+/* log session commit
+ * 로그 세션은 2단계로 종료됨. 1) tail log 기록 2) commit marker 기록
+ * commit marker는 TYPE_EXT_LOG(LOG_STAT_COMMIT) 1word로 세션 번호와 검증값을 가지며
+ * tail log와 같은 페이지 바로 다음 word에 기록됨.
+ * 부팅시 마지막 페이지의 마지막 word만으로 세션 종료/중단 여부를 판단함. */
+#define LOG_SESS_SEQ_MASK   0x3FFF
+#define LOG_COMMIT_WORDS    (LOG_RECORD_MAX_WORDS + 1)
+#define LOG_COMMIT_CHECK(seq)   ((~((seq) ^ ((seq) >> 10))) & 0x3FF)
+
+//ring별 로그 RAM 버퍼 크기와 한번의 flush 이벤트에서 기록할 로그 개수
+#define LOG_STAGE_SIZE  16
+#define LOG_FLUSH_BURST 8
+
+//미리 지워둘 다음 로그페이지 개수
+#define LOG_PRE_ERASE_CNT   2
+
+/* log query
+ * type_mask 하위 8bit는 normal/head log의 log_evt(LOG_EVT_XXX)와 비교하고
+ * 상위 bit는 로그 종류(TYPE_XXX_LOG) 단위로 선택함. */
+#define LOG_QRY_EVT(evt)    ((evt) & 0xFF)
+#define LOG_QRY_KIND(type)  (0x100 << (type))
+#define LOG_QRY_ALL         0x0FFF
+
+//로그 읽기시 한번에 읽어두는 word 수, 페이지(512word)를 나누어 떨어지게 하는 2의 거듭제곱
+#define LOG_READ_WIN    16
+
+/* charge telemetry aggregation
+ * 충전중 샘플을 LOG_AGGR_WINDOW개씩 모아 항목별 min/max/mean과 샘플 개수만 기록.
+ * 직전 raw 기록값과 임계값 이상 차이나는 샘플은 raw 값으로도 기록하여 곡선 형태를 유지함. */
+#define LOG_AGGR_CH_CNT     3
+#define LOG_AGGR_WINDOW     60      //CHRGED_LOG_PERIOD(10초) * 60 = 10분
+#define LOG_AGGR_DELTA_VOLT 50      //[mV]
+#define LOG_AGGR_DELTA_CURR 200     //[mA]
+#define LOG_AGGR_DELTA_TEMP 20      //[0.1'C]
+
+typedef union _LOG_DATA {
+    struct {
+        uint8 log_evt : 8;      //로그 이벤트 및 상태 플레그 (LOG_HEAD_XXX)
+        uint16 log_value : 16;  //로그 값, tail log의 경우 head log의 주소
+        uint8 log_type : 2;     //TYPE_XXX_LOG
+        uint8 clc_flag : 1;
+        uint8 data_type : 5;    //데이터 항목 (전압, 전류, 충격, 온도)
+    };
+    uint32 data_all;
+}log_data_t;
+
+//플래시에 기록되는 1word 로그 형식
+typedef union _LOG_WORD {
+    struct {
+        uint32 log_evt : 8;
+        uint32 log_value : 16;
+        uint32 log_type : 2;    //TYPE_XXX_LOG
+        uint32 delta_t : 6;     //직전 로그와의 시간차(sec)
+    } rec;
+    struct {
+        uint32 time_value : 24; //절대 시각(sec)
+        uint32 log_type : 2;    //TYPE_EXT_LOG
+        uint32 ext_type : 6;    //LOG_STAT_TIME
+    } time;
+    struct {
+        uint32 ext_value : 24;  //항목의 통계값 또는 raw값
+        uint32 log_type : 2;    //TYPE_EXT_LOG
+        uint32 ext_type : 6;    //LOG_EXT_TYPE(stat, item)
+    } ext;
+    struct {
+        uint32 sess_seq : 14;   //commit된 로그 세션 번호
+        uint32 check : 10;      //LOG_COMMIT_CHECK(sess_seq), 기록 도중 끊긴 marker 판별
+        uint32 log_type : 2;    //TYPE_EXT_LOG
+        uint32 ext_type : 6;    //LOG_EXT_TYPE(LOG_STAT_COMMIT, LOG_ITEM_NONE)
+    } commit;
+    uint32 data_all;
+}log_word_t;
+
+typedef struct _LOG_ADDRESS {
+    uint16 head_addr;
+    uint16 tail_addr;
+    uint16 offset_addr;
+    uint16 log_cnt;
+
+    //현재 기록중인 로그 페이지 정보
+    uint16 page_seq;
+    uint16 page_cnt;
+    uint16 page_head;
+
+    //마지막으로 기록한 로그 시각, offset_addr 위치 직전 로그의 시각
+    uint32 last_time;
+    uint32 read_time;
+
+    //마지막으로 commit된 로그 세션 번호
+    uint16 sess_seq;
+
+    //현재 페이지 로그들의 이벤트/종류 bitmap, 페이지를 닫을때 index word로 기록
+    uint8 page_evt;
+    uint8 page_kind;
+    uint8 page_mono;    //페이지 로그 시각이 되돌아간 적 없음(재부팅 없음), 시간 범위 기록 가능
+
+    //로그 ring 번호와 ring이 사용하는 페이지 범위
+    uint8 ring;
+    uint8 pg_st;
+    uint8 pg_ed;
+}log_addr_t;
+
+typedef struct _LOG_PAGE_HEADER {
+    uint32 erase_cnt;               //flash_page_erase로 기록되는 지우기 횟수, FLASH_WEAR_WORD 형식
+    union {
+        struct {
+            uint32 seq : 16;        //페이지가 열릴때마다 증가하는 일련번호
+            uint32 first_rec : 9;   //페이지 내 첫 로그의 offset
+            uint32 state : 3;       //PAGE_ST_XXX
+            uint32 version : 4;
+        };
+        uint32 data_all;
+    } open;
+    uint32 base_time;
+    union {
+        struct {
+            uint32 rec_cnt : 9;     //페이지에 기록된 word 개수 (로그 + time record)
+            uint32 last_head : 9;   //페이지 내 마지막 head log의 offset
+            uint32 sess_seq : 14;   //페이지를 열때 마지막으로 commit된 세션 번호
+        };
+        uint32 data_all;
+    } close;
     union {
         struct {
-            uint16 log_type : 4;
-            uint16 events : 8;
-            uint16 values : 16;
+            uint32 evt_mask : 8;    //normal/head log의 log_evt OR 값
+            uint32 kind_mask : 4;   //기록된 로그 종류, (1 << TYPE_XXX_LOG)
+            uint32 span : 20;       //base time부터 마지막 로그까지의 시간(sec), LOG_SPAN_UNKNOWN
         };
-        uint32 package;
-    } datas;
+        uint32 data_all;
+    } index;
+}log_page_hdr_t;
 
-    uint32 time;
+typedef struct _LOG_QUERY {
+    uint16 type_mask;   //LOG_QRY_EVT() | LOG_QRY_KIND()
+    uint32 t_from;      //검색할 로그 시각 범위(sec)
+    uint32 t_to;
 
-} st_newLog_t;
+    //검색 위치, cursor가 0이면 ring의 가장 오래된 페이지부터 검색
+    uint16 cursor;
+    uint16 page_seq;
+    uint8 page;
+    uint32 read_time;   //cursor 직전 로그의 시각
+    uint16 match_cnt;   //지금까지 찾은 로그 개수
+}log_query_t;
 
-uint8 log_system_init(log_data_t *apst_log, log_addr_t *apst_addr);
-uint8 LogAddress_valid_check(uint16 addr);
+typedef struct _LOG_AGGR_CHANNEL {
+    int16 min;
+    int16 max;
+    int32 sum;
+    int16 last_raw;     //마지막으로 raw 기록한 값
+    int16 delta;        //raw 기록 임계값
+}log_aggr_ch_t;
 
-void generate_new_log_address(log_addr_t *apst_addr);
+typedef struct _LOG_AGGREGATION {
+    log_aggr_ch_t ch[LOG_AGGR_CH_CNT];  //LOG_ITEM_XXX - 1 순서
+    uint16 cnt;
+    uint16 window;
+    uint8 raw_valid;
+}log_aggr_t;
 
-uint16 get_key_address();
-void stroed_key_value(log_addr_t *apst_addr);
+uint8 log_system_init(log_data_t *apst_log, log_addr_t *apst_addr, uint8 ring);
 
-uint16 analysis_keylog(uint16 key_addr);
-uint16 analysis_tail_log(uint16 key_value);
-uint16 search_head_log(uint16 offset);
+void generate_new_log_address(log_addr_t *apst_addr, uint32 time);
+
+void read_log_page_hdr(uint8 pg, log_page_hdr_t *apst_hdr);
+uint8 recover_log_addresses(log_addr_t *apst_addr);
+uint16 log_next_addr(log_addr_t *apst_addr, uint16 addr);
+uint32 log_base_time(uint16 addr);
+void log_read_begin(log_addr_t *apst_addr);
+uint8 log_read_record(log_addr_t *apst_addr, log_data_t *apst_data, time_data_t *apst_times);
+
+void log_query_begin(log_query_t *apst_qry, uint16 type_mask, uint32 t_from, uint32 t_to);
+uint8 log_query(log_addr_t *apst_addr, log_query_t *apst_qry, log_data_t *apst_data, time_data_t *apst_times);
 
 uint8 stored_log_data(log_addr_t *apst_addr, log_data_t *apst_data, time_data_t *apst_times);
-uint16 wrtie_tail_log(uint16 ai_addr, Control_flag_t ast_flag);
+uint8 log_stage_push(log_addr_t *apst_addr, log_data_t *apst_data, time_data_t *apst_times);
+uint8 log_stage_flush(log_addr_t *apst_addr, uint8 max_cnt);
+uint8 log_stage_count(log_addr_t *apst_addr);
+uint8 log_event_store(log_addr_t *apst_addr, log_data_t *apst_data, time_data_t *apst_times);
+uint8 wrtie_tail_log(log_addr_t *apst_addr, Control_flag_t ast_flag, time_data_t *apst_times);
+uint8 log_session_close(log_addr_t *apst_addr, Control_flag_t ast_flag, time_data_t *apst_times);
+
+void get_log_write_stats(uint32 *records, uint32 *write_cycles);
+
+uint8 log_pre_erase(log_addr_t *apst_addr);
+void get_log_erase_stats(uint16 *avoided, uint16 *inline_cnt);
+void get_log_wear_histogram(uint16 *p_hist, uint8 bins, uint32 *p_min, uint32 *p_max);
 
-uint16 calc_number_of_LogDatas(log_addr_t ast_addr);
+void log_aggr_init(log_aggr_t *apst_aggr, uint16 window);
+void log_aggr_set_delta(log_aggr_t *apst_aggr, uint8 item, int16 delta);
+uint8 log_aggr_sample(log_addr_t *apst_addr, log_aggr_t *apst_aggr, int16 *p_values, uint32 time);
+uint8 log_aggr_flush(log_addr_t *apst_addr, log_aggr_t *apst_aggr, uint32 time);
+uint8 log_raw_push(log_addr_t *apst_addr, uint8 item, int16 value, uint32 time);
 
 #endif
\ No newline at end of file
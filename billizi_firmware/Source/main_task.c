@@ -5,6 +5,7 @@
 #include "log_mgr.h"
 #include "ble_service_mgr.h"
 #include "boot_mgr.h"
+#include "sched_mgr.h"
 
 #if defined FEATURE_OAD
   #include "oad.h"
@@ -23,13 +24,31 @@ uint8 *tx_buff;
 Control_flag_t ctrl_flags;
 
 static time_data_t st_Times;
-static log_addr_t st_LogAddr;
+static log_addr_t st_LogAddr;       //방전/대여 로그 ring, 키오스크로 전송
+static log_addr_t st_ChgLogAddr;    //충전 텔레메트리 ring
+static log_addr_t st_EvtLogAddr;    //이상 이벤트 ring
+static log_addr_t *const pst_LogRings[LOG_RING_CNT] = {&st_ChgLogAddr, &st_LogAddr, &st_EvtLogAddr};
 static log_data_t st_BattLog;
+static log_aggr_t st_ChgAggr;
+static uint8 erase_ring = 0;        //EVT_LOG_ERASE에서 미리 지우기를 진행할 ring
 
 static uint32 sys_timer;
 static uint32 main_timer;
 static uint16 timer_cnt;
 
+//adaptive sampling schedule, 판정 기준 근처이거나 변화가 있으면 빨라짐
+static const uint16 sched_ext_th[] = {EXT_COMM_MV, EXT_MIN_MV};
+static const uint16 sched_curr_th[] = {CHG_TERM_CURR_MA};
+static const uint16 sched_batt_th[] = {MIN_BATT_MV, SERVICE_BATT_MV};
+static sched_sig_t sched_sigs[SCHED_SIG_CNT] = {
+    {500, 1500, sched_ext_th, 2},   //외부전압, hysteresis 구간까지 포함
+    {60, 100, sched_curr_th, 1},    //전류, 측정 잡음(약 14mA rms)보다 충분히 크게
+    {30, 30, sched_batt_th, 2}      //배터리 전압
+};
+static sched_mgr_t st_Sched;
+static uint16 sched_state;          //sched 주기로 예약된 state
+static uint8 sched_state_pending;   //sched_state가 sched 주기로 예약되어 있음
+
 batt_info_t batt_status;
 sensor_info_t sensor_vals;
 
@@ -43,36 +62,19 @@ static uint8 load_adc_calib_val(Control_flag_t *apst_flags)
 		1: load successfuly
 		0: laod fail
 	*/
-    flash_16bit_t tmp_flash;
-    uint16 calib_value;
-
-    read_flash(FLADDR_CALIB_REF, FLOPT_UINT32, &tmp_flash.all_bits);
-    if(tmp_flash.all_bits == EMPTY_FLASH) {
-        //calibration value has never been set.
-        //need factory initialize
-        //need ADC calibration 
-        return 0;
-    }
-
-    if(tmp_flash.all_bits == 0) {
-        //this battery use self-calibration.
-        calib_value = search_self_calib();
-    } else if (tmp_flash.high_16bit == 0x1000) {
-        //adc system setup reference calibration value
-        setup_calib_value(FALSE, tmp_flash.low_16bit);
-        apst_flags->ref_calib = 1;
-        return 1;
-    }
-
-    if (!calib_value) {
-        //not found ADC Calibration value.
-        //need factory initialize
-        //need ADC calibration 
-        return 10
-    }else {
-        //adc system setup self-calibartion value
-        setup_calib_value(TRUE, calib_value);
-        apst_flags->self_calib = 1;
+    //설정 저장소에서 보정값을 읽어 RAM의 보정 배율 설정
+    switch (calib_load()) {
+        case CALIB_REF:
+            apst_flags->ref_calib = 1;
+            break;
+        case CALIB_SELF:
+            apst_flags->self_calib = 1;
+            break;
+        default:
+            //calibration value has never been set.
+            //need factory initialize
+            //need ADC calibration 
+            return 0;
     }
 
     return 1;
@@ -109,15 +111,13 @@ static uint8 current_battery_status_check(Control_flag_t *apst_flag)
 
 	*/
 
-	if (!check_cable_status()) {
-		apst_flag->abnormal |= ERR_BROKEN_CABLE;
-	}
+	// 케이블 검사는 BlzBat_Init에서 비동기로 시작, 결과는 cable_check_done에서 반영
 
-    if (read_temperature() >= 700) {
+    if (read_temperature() >= TEMP_OVER) {
         apst_flag->abnormal |= ERR_TEMP_OVER;
     }
 
-    if (read_voltage(READ_BATT_SIDE) < MIN_BATT_V) {
+    if (read_voltage(READ_BATT_SIDE) < MIN_BATT_MV) {
         apst_flag->abnormal |= ERR_LOSS_BATTERY;
     }
 
@@ -165,19 +165,53 @@ void get_main_params(uint8 opt, void *pValue)
         case PARAM_EVT_VALS:
             *((uint16*)pValue) = debug_vars;
             break;
+        case PARAM_LOG_CHG:
+            *((log_addr_t*)pValue) = st_ChgLogAddr;
+            break;
+        case PARAM_LOG_EVT:
+            *((log_addr_t*)pValue) = st_EvtLogAddr;
+            break;
+        case PARAM_BATT_INFO:
+            *((batt_info_t*)pValue) = batt_status;
+            break;
     }
 }
 
 uint8 set_log_data(uint16 status, uint16 log_value)
 {
-    if(ctrl_flags.logging) {
-        /* 아직 로그가 기록이 완료 되지 않은상태.
-         * 로그가 기록 될때까지 로그데이터가 덮어씌워짐을 방지 */
+    uint8 i, err = 0;
+
+    st_BattLog.data_all = 0;
+    st_BattLog.log_evt = (uint8)status;
+    st_BattLog.log_value = log_value;
+    st_BattLog.log_type = TYPE_NORMAL_LOG;
+
+    st_Times.log_evt = LOG_HEAD_TIME;
+    st_Times.time_value = osal_GetSystemClock() / 1000;
+
+    //이상 이벤트는 충전 텔레메트리에 덮어쓰이지 않도록 이벤트 ring에도 즉시 기록
+    if (status & LOG_EVT_ABNORMAL) {
+        log_event_store(&st_EvtLogAddr, &st_BattLog, &st_Times);
+    }
+
+    /* 로그는 RAM 버퍼에 쌓아두고 EVT_LOG_FLUSH 이벤트에서 플래시에 기록.
+     * 안전 관련 이벤트는 버퍼에 남아있는 로그까지 즉시 기록 */
+    if (log_stage_push(&st_LogAddr, &st_BattLog, &st_Times)) {
         return 1;
     }
 
-    //구조 수정중..
-    
+    if (status & LOG_EVT_CRITICAL) {
+        osal_stop_timerEx(main_taskID, EVT_LOG_FLUSH);
+        for (i = 0; i < LOG_RING_CNT; i++) {
+            err |= log_stage_flush(pst_LogRings[i], LOG_STAGE_SIZE);
+        }
+        if (err) {
+            return 1;
+        }
+    } else if (!osal_get_timeoutEx(main_taskID, EVT_LOG_FLUSH)) {
+        osal_start_timerEx(main_taskID, EVT_LOG_FLUSH, LOG_FLUSH_DELAY);
+    }
+
     //success
     return 0;
 }
@@ -210,7 +244,7 @@ uint16 Battery_Monitoring_Process(uint8 task_id, uint16 events)
     }
 
     sensor_vals.temperature = read_temperature();
-    if (sensor_vals.temperature >= 700) {
+    if (sensor_vals.temperature >= TEMP_OVER) {
         //70.0도 이상일때 로깅
         print_uart("temp-%d\r\n", sensor_vals.temperature);
     }
@@ -220,7 +254,6 @@ uint16 Battery_Monitoring_Process(uint8 task_id, uint16 events)
 
 uint16 Kiosk_Process(uint8 task_id, uint16 events)
 { // task_15
-    float tmp_voltage;
     uint16 next_evt;
     uint8 next_task;
 
@@ -230,11 +263,9 @@ uint16 Kiosk_Process(uint8 task_id, uint16 events)
     debug_vars = events;
 
     if (events & EVT_EXT_V_MONITORING) { // task_15_EVT_EXT_V_MONITORING
-        tmp_voltage = read_voltage(READ_EXT);
-
         if (check_timer(sys_timer, 50)) {
             //check the external voltage every interval 100ms
-            switch (ext_voltage_analysis(tmp_voltage)) {
+            switch (ext_voltage_result()) {
                 case EXT_COMM_V:
                     next_evt = EVT_COMM;
                     uart_enable();
@@ -249,8 +280,7 @@ uint16 Kiosk_Process(uint8 task_id, uint16 events)
     }
 
     if (events & EVT_COMM) {
-        tmp_voltage = read_voltage(READ_EXT);
-        switch(ext_voltage_analysis(tmp_voltage)) {
+        switch(ext_voltage_result()) {
             case EXT_MIN_V:
                 if (check_timer(sys_timer, 100)) {
                     osal_mem_free(tx_buff);
@@ -261,7 +291,6 @@ uint16 Kiosk_Process(uint8 task_id, uint16 events)
                         next_evt = EVT_CHARGE;
 
                         batt_status.hysteresis_cnt = 0;
-                        stroed_key_value(&st_LogAddr);
 
                         charge_enable();
                         ctrl_flags.need_comm = 0;
@@ -279,7 +308,7 @@ uint16 Kiosk_Process(uint8 task_id, uint16 events)
                     if (st_LogAddr.offset_addr == 0) {
                         tx_buff = get_head_packet(&ctrl_flags, &batt_status, st_LogAddr.log_cnt);
                         st_LogAddr.log_cnt = 0;
-                        st_LogAddr.offset_addr = st_LogAddr.head_addr;
+                        log_read_begin(&st_LogAddr);
                     } else {
                         tx_buff = get_log_packet(&st_LogAddr);
                     }
@@ -309,18 +338,16 @@ uint16 Kiosk_Process(uint8 task_id, uint16 events)
 
     if (events & EVT_CHARGE) {
         //uart_enable();
-        tmp_voltage = read_voltage(READ_EXT);
-
         if (check_timer(sys_timer, 10)) {
-            switch(ext_voltage_analysis(tmp_voltage)) {
+            switch(ext_voltage_result()) {
                 case EXT_MIN_V:
                     batt_status.current = read_current(READ_CURR_CHG);
 
-                    // batt_status.batt_v = read_voltage(READ_BATT_SIDE);
-                    // batt_status.batt_v -= ((SHUNT_R_VAL * batt_status.current) / 1000);
+                    // batt_status.batt_mv = read_voltage(READ_BATT_SIDE);
+                    // batt_status.batt_mv -= ((SHUNT_R_MOHM * batt_status.current) / 1000);
 
                     if (CHG_EN) {
-                        if (batt_status.current <= 300) {
+                        if (batt_status.current <= CHG_TERM_CURR_MA) {
                             //print_uart("%.2f\r\n", batt_status.current);
                             batt_status.hysteresis_cnt++;
                         } else {
@@ -334,14 +361,10 @@ uint16 Kiosk_Process(uint8 task_id, uint16 events)
                     break;
             }
 
-            if(batt_status.hysteresis_cnt >= 100) {
+            if(batt_status.hysteresis_cnt >= CHG_TERM_CNT) {
                 //full charge
                 charge_disable();
               
-                update_self_calibration(ctrl_flags.self_calib, read_adc_sampling(10, READ_BATT_SIDE));
-
-                setup_calib_value(TRUE, search_self_calib());
-                ctrl_flags.self_calib = 1;
                 batt_status.hysteresis_cnt = 0;
                 next_evt = EVT_HOLD_BATT;
             }
@@ -366,9 +389,7 @@ uint16 Kiosk_Process(uint8 task_id, uint16 events)
 
     if (events & EVT_HOLD_BATT) {
         if (check_timer(sys_timer, 10)) {
-            tmp_voltage = read_voltage_sampling(10, READ_EXT);
-
-            switch (ext_voltage_analysis(tmp_voltage)) {
+            switch (ext_voltage_result()) {
                 case EXT_COMM_V:// 통신 전압이 유지되면, 키오스크 안에 있다고 판단
                     if (timer_cnt > 0) { //100이전에 통신 전압이 걸릴 경우
                         timer_cnt = 0;
@@ -376,12 +397,12 @@ uint16 Kiosk_Process(uint8 task_id, uint16 events)
                         uart_enable();
                         sys_timer = osal_GetSystemClock();
 
-                        print_uart("batt-%.2f\r\n", batt_status.batt_v);
+                        print_uart("batt-%u\r\n", batt_status.batt_mv);
                     }
                     break;
                 case EXT_MIN_V:
-                    // batt_status.batt_v = read_voltage(READ_BATT_SIDE);
-                    // if (batt_status.batt_v < MAX_BATT_V) {
+                    // batt_status.batt_mv = read_voltage(READ_BATT_SIDE);
+                    // if (batt_status.batt_mv < MAX_BATT_MV) {
                         TXD_PIO = 0;
                         timer_cnt = 0;
                         next_evt = EVT_CHARGE;
@@ -406,15 +427,14 @@ uint16 Kiosk_Process(uint8 task_id, uint16 events)
 
     if (events & EVT_BATT_INFO_REQ) {
         if (tx_buff == NULL) {
-            batt_status.batt_v = read_voltage(READ_BATT_SIDE);
+            batt_status.batt_mv = read_voltage(READ_BATT_SIDE);
             tx_buff = get_head_packet(&ctrl_flags, &batt_status, st_LogAddr.log_cnt);
         }else {
             transmit_data_stream(BATT_INFO_LEN, tx_buff);
         }
 
         if (check_timer(sys_timer, 10)) {
-            tmp_voltage = read_voltage(READ_EXT);
-            switch (ext_voltage_analysis(tmp_voltage)) {
+            switch (ext_voltage_result()) {
                 case EXT_MIN_V:
                     timer_cnt++;
                     break;
@@ -453,8 +473,8 @@ uint16 Abnormal_Process(uint8 task_id, uint16 events)
 { //task_16
     uint16 next_evt = events;
     uint8 next_task = task_id;
+    uint8 i;
 
-    float ext_voltage;
     debug_vars = events;
     //log_data_t tmp_logdata;
 
@@ -462,12 +482,11 @@ uint16 Abnormal_Process(uint8 task_id, uint16 events)
 
     if (ctrl_flags.abnormal & ERR_COMMUNICATION) {
         if (st_LogAddr.head_addr != st_LogAddr.offset_addr) {
-            st_LogAddr.offset_addr = st_LogAddr.head_addr;
+            log_read_begin(&st_LogAddr);
         }
 
         if (check_timer(sys_timer, 500)) {
-            ext_voltage = read_voltage(READ_EXT);
-            if (ext_voltage >= EXT_MIN_V) {
+            if (ext_voltage_result() == EXT_MIN_V) {
                 next_evt = TASK_KIOSK;
                 ctrl_flags.abnormal &= ~(ERR_COMMUNICATION);
                 next_task = main_taskID;
@@ -478,25 +497,23 @@ uint16 Abnormal_Process(uint8 task_id, uint16 events)
 
 
     if (ctrl_flags.abnormal & ERR_LOSS_BATTERY) {
-        //print_uart("%.2f\r\n", read_voltage(READ_BATT_SIDE));
-        if(read_voltage(READ_BATT_SIDE) > MIN_BATT_V) {
+        //print_uart("%u\r\n", read_voltage(READ_BATT_SIDE));
+        if(read_voltage(READ_BATT_SIDE) > MIN_BATT_MV) {
             next_evt = TASK_USER_SERVICE;
             next_task = main_taskID;
         }
     }
 
     if (ctrl_flags.abnormal & ERR_FLASH_MEMS) {
-        st_LogAddr.key_addr = get_key_address();
-        st_LogAddr.tail_addr = analysis_keylog(st_LogAddr.key_addr);
-
-        st_LogAddr.head_addr = st_LogAddr.tail_addr;
-
-        if (!st_LogAddr.tail_addr) {
-            st_LogAddr.head_addr = 0;
-            HalFlashErase(ADDR_2_PAGE(FLADDR_LOGDATA_ST));
+        //ring별로 페이지 헤더로 마지막 로그 위치 복구, 복구 불가시 해당 ring 초기화
+        for (i = 0; i < LOG_RING_CNT; i++) {
+            if (recover_log_addresses(pst_LogRings[i])) {
+                flash_page_erase(pst_LogRings[i]->pg_st);
+                pst_LogRings[i]->head_addr = 0;
+                pst_LogRings[i]->tail_addr = 0;
+                pst_LogRings[i]->offset_addr = 0;
+            }
         }
-
-        HalFlashErase(ADDR_2_PAGE(st_LogAddr.tail_addr));
         ctrl_flags.abnormal &= ~(ERR_FLASH_MEMS);
 
         next_evt = TASK_USER_SERVICE;
@@ -527,6 +544,8 @@ static uint8 giExtVoltChged = 0;
 static uint8 giExtVoltComm = 0;
 static uint8 giExtVoltZero = 0;
 static uint8 giChgingCnt;
+static uint16 gu16CurState = STATE_BOOT;
+static uint8 gu8ChgFull = FALSE;	// 만충 후 재충전 전압까지 내려가지 않음
 
 #define CHRGED_LOG_PERIOD		10
 #define MAX_UINT8				254	
@@ -611,6 +630,52 @@ uint8 chk_ext_volt_chg()
 	return 0;
 }
 
+/* state별 sampling 주기 {adc_min, adc_max, poll_min, poll_max}(ms)
+ * adc_max는 coulomb counter 적분 간격 제한(CC_MAX_DT) 이하로 유지 */
+static const sched_profile_t sched_fast = {ADC_SAMPLE_PERIOD, ADC_SAMPLE_PERIOD, 10, 10};
+static const sched_profile_t sched_kiosk = {ADC_SAMPLE_PERIOD, 160, 100, 800};
+static const sched_profile_t sched_chging = {ADC_SAMPLE_PERIOD, 80, 1000, 1000};
+static const sched_profile_t sched_zero = {ADC_SAMPLE_PERIOD, 40, 100, 100};
+static const sched_profile_t sched_out = {20, 640, 250, 4000};
+static const sched_profile_t sched_dischg = {20, 320, 1000, 1000};
+
+const sched_profile_t *state_sched_profile(uint16 au16State)
+{ // state별 sampling 주기, 부팅/통신은 항상 최소 주기
+	switch (au16State) {
+		case STATE_IN_KIOSK :
+		case STATE_IN_KIOSK_CHRGED :
+			return &sched_kiosk;
+		case STATE_IN_KIOSK_EXT_VOLT_ZERO :
+			return &sched_zero;
+		case STATE_IN_KIOSK_CHGING :
+			return &sched_chging;
+		case STATE_OUT_KIOSK :
+		case STATE_OUT_KIOSK_SLEEP :
+		case STATE_OUT_KIOSK_DEEP_SLEEP :
+		case STATE_OUT_KIOSK_POWEROFF :
+			return &sched_out;
+		case STATE_OUT_KIOSK_DISCHGING_USB_A :
+		case STATE_OUT_KIOSK_DISCHGING_BLZ_CONN :
+			return &sched_dischg;
+	}
+	return &sched_fast;
+}
+
+uint8 chk_idle_state(uint16 au16State)
+{ // 페이지 지우기 등 오래 걸리는 작업을 해도 되는 상태인지 확인
+	switch (au16State) {
+		case STATE_IN_KIOSK_CHGING :
+		case STATE_IN_KIOSK_COMM :
+		case STATE_IN_KIOSK_COMM_CHGING_STATUS :
+		case STATE_IN_KIOSK_COMM_CHGING_LOG :
+		case STATE_IN_KIOSK_COMM_DISCHGING_LOG :
+		case STATE_OUT_KIOSK_DISCHGING_USB_A :
+		case STATE_OUT_KIOSK_DISCHGING_BLZ_CONN :
+			return 0;
+	}
+	return 1;
+}
+
 uint8 chk_blz_conn()
 {
 	return 0;
@@ -622,8 +687,33 @@ uint8 chk_chargeable()
 }
 
 uint8 chk_charging()
-{
-	return 0;
+{ // 충전 완료 판정은 EVT_ADC_SAMPLE의 chg_term_update에서 진행
+	return (batt_status.hysteresis_cnt < CHG_TERM_CNT);
+}
+
+uint8 chk_recharge()
+{ // 만충 이후에는 배터리 전압이 CHG_RESTART_MV 아래로 내려간 경우에만 다시 충전
+	if (gu8ChgFull && read_voltage(READ_BATT_SIDE) >= CHG_RESTART_MV) {
+		return 0;
+	}
+	gu8ChgFull = FALSE;
+	return 1;
+}
+
+uint8 chg_term_update()
+{ // sampler tick마다 충전 전류 검사, TRUE: 이번 tick에 충전 완료 조건이 됨
+	if (!CHG_EN) {
+		batt_status.hysteresis_cnt = 0;
+		return FALSE;
+	}
+
+	batt_status.current = read_current(READ_CURR_CHG);
+	if (batt_status.current > CHG_TERM_CURR_MA) {
+		batt_status.hysteresis_cnt = 0;
+		return FALSE;
+	}
+
+	return (++batt_status.hysteresis_cnt == CHG_TERM_CNT);
 }
 
 uint8 chk_discharging()
@@ -632,8 +722,8 @@ uint8 chk_discharging()
 }
 
 uint8 chk_in_kiosk()
-{
-	return 0;
+{ // 키오스크 밖에서 외부전압이 다시 검출되면 삽입, 판정은 ext_class_update의 debounce 결과
+	return (ext_voltage_result() != EXT_ZERO_V);
 }
 
 uint8 chk_low_voltage()
@@ -661,13 +751,45 @@ void do_enable_usb_a()
 	return;
 }
 
-uint8 ext_voltage_result()
-{
+static void close_log_session(log_addr_t *apst_addr)
+{ // 로그 세션을 commit, 재부팅시 끊긴 세션으로 처리되지 않음
+	time_data_t end_time;
+
+	end_time.log_evt = LOG_HEAD_TIME;
+	end_time.time_value = osal_GetSystemClock() / 1000;
+	if (log_session_close(apst_addr, ctrl_flags, &end_time) && !osal_get_timeoutEx(main_taskID, EVT_LOG_FLUSH)) {
+		// 기록하지 못한 로그는 EVT_LOG_FLUSH에서 다시 시도, 세션은 다음 종료시 commit
+		osal_start_timerEx(main_taskID, EVT_LOG_FLUSH, LOG_FLUSH_DELAY);
+	}
 	return;
 }
 
 void save_charging_log()
-{
+{ // 충전 전압/전류/온도 샘플을 집계, 요약 및 변곡점만 로그로 기록
+	int16 samples[LOG_AGGR_CH_CNT];
+
+	samples[LOG_ITEM_VOLT - 1] = (int16)read_voltage(READ_BATT_SIDE);
+	samples[LOG_ITEM_CURR - 1] = (int16)read_current(READ_CURR_CHG);
+	samples[LOG_ITEM_TEMP - 1] = read_temperature();
+
+	log_aggr_sample(&st_ChgLogAddr, &st_ChgAggr, samples, osal_GetSystemClock() / 1000);
+	if (!osal_get_timeoutEx(main_taskID, EVT_LOG_FLUSH)) {
+		osal_start_timerEx(main_taskID, EVT_LOG_FLUSH, LOG_FLUSH_DELAY);
+	}
+	return;
+}
+
+void cable_check_done(uint8 result, uint16 resp_ms)
+{ // 빌리지 케이블 검사 결과, PMIC 응답시간은 결과와 관계없이 텔레메트리로 기록
+	log_raw_push(&st_ChgLogAddr, LOG_ITEM_PMIC, (int16)resp_ms, osal_GetSystemClock() / 1000);
+	if (!osal_get_timeoutEx(main_taskID, EVT_LOG_FLUSH)) {
+		osal_start_timerEx(main_taskID, EVT_LOG_FLUSH, LOG_FLUSH_DELAY);
+	}
+
+	if (result != CABLE_OK) {
+		ctrl_flags.abnormal |= ERR_BROKEN_CABLE;
+		set_log_data(LOG_EVT_BRK_CABLE, result);
+	}
 	return;
 }
 
@@ -676,6 +798,12 @@ void save_discharging_log()
 	return;
 }
 
+void stop_discharging()
+{ // 방전 종료, 방전 로그 세션 종료
+	close_log_session(&st_LogAddr);
+	return;
+}
+
 uint8 send_to_chg_comm(uint16 au16Events)
 {
 	return 0;
@@ -683,6 +811,10 @@ uint8 send_to_chg_comm(uint16 au16Events)
 
 void start_charging()
 {
+	if (ctrl_flags.abnormal & ERR_TEMP_OVER) {
+		// 과열 중에는 OS 해제 전까지 충전하지 않음
+		return;
+	}
 	charge_enable();
 	return;
 }
@@ -690,6 +822,9 @@ void start_charging()
 void stop_charging()
 {
 	charge_disable();
+	// 충전 종료, 남은 샘플 요약 기록 후 충전 로그 세션 종료
+	log_aggr_flush(&st_ChgLogAddr, &st_ChgAggr, osal_GetSystemClock() / 1000);
+	close_log_session(&st_ChgLogAddr);
 	return;
 }
 
@@ -719,29 +854,143 @@ void BlzBat_Init(uint8 task_id)
     //disable halt during RF (needed for UART / SPI)
     HCI_EXT_HaltDuringRfCmd(HCI_EXT_HALT_DURING_RF_DISABLE);
 
-    log_system_init(&st_BattLog, &st_LogAddr);
+    //설정값 RAM index 생성, 이후 conntype/calibration은 RAM에서 읽음
+    settings_init();
+
+    log_system_init(&st_BattLog, &st_ChgLogAddr, LOG_RING_CHG);
+    log_system_init(&st_BattLog, &st_LogAddr, LOG_RING_DISCHG);
+    log_system_init(&st_BattLog, &st_EvtLogAddr, LOG_RING_EVT);
+    log_aggr_init(&st_ChgAggr, LOG_AGGR_WINDOW);
     st_Times.log_evt = LOG_HEAD_TIME;
     st_Times.time_value = 0;
 
     sensor_status_init(&sensor_vals);
     ctrl_flags.flag_all = 0;
+    load_adc_calib_val(&ctrl_flags);
+
+    //이후 전압/전류 읽기는 background sampler의 ring buffer에서 바로 반환됨
+    adc_sampler_start();
+    sched_init(&st_Sched, sched_sigs, SCHED_SIG_CNT, state_sched_profile(STATE_BOOT));
+    osal_start_timerEx(task_id, EVT_ADC_SAMPLE, ADC_SAMPLE_PERIOD);
+    osal_start_reload_timer(task_id, EVT_TEMP_READ, TEMP_PERIOD);
+    temp_alert_init(task_id, EVT_TEMP_ALERT);
+    batt_soc_init(&batt_status, osal_GetSystemClock());
 
     tx_buff = NULL;
 
     GAPRole_Serv_Start();
     //ble_advert_control(FALSE);
     ble_advert_control(TRUE);
+
+    osal_start_timerEx(task_id, EVT_LOG_ERASE, LOG_ERASE_RETRY);
     
-	osal_set_event(task_id, STATE_BOOT);
+	// STATE_BOOT는 0이라 event로 보낼 수 없으므로 부팅 처리는 여기서 하고 다음 state로 시작
+	cable_check_start(task_id, EVT_CABLE_CHECK, cable_check_done);
+	osal_set_event(task_id, STATE_IN_KIOSK);
 } // void BlzBat_Init(uint8 task_id)
 
 uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 {
-	print_uart("main process event\r\n");
     VOID task_id;  // OSAL required parameter that isn't used in this function
 
 	uint16 next_state = events;
 	uint16 next_state_dly = 0;
+	uint8 i, log_remain;
+	uint16 sched_vals[SCHED_SIG_CNT];
+
+	if (events & EVT_ADC_SAMPLE) {
+		adc_sampler_tick();
+		ext_class_update();
+		// 직전 주기까지의 전류로 남은 용량 적분
+		batt_soc_update(&batt_status, osal_GetSystemClock());
+
+		// 다음 주기 결정, 모두 filter 출력이므로 추가 변환 없음
+		sched_vals[SCHED_SIG_EXT] = read_voltage(READ_EXT);
+		sched_vals[SCHED_SIG_CURR] = read_current(READ_CURR_CHG) + read_current(READ_CURR_DISCHG);
+		sched_vals[SCHED_SIG_BATT] = read_voltage(READ_BATT_SIDE);
+		if (sched_update(&st_Sched, sched_vals, ext_voltage_time() < EXT_SETTLE_TICKS)
+			&& sched_state_pending
+			&& osal_get_timeoutEx(main_taskID, sched_state) > sched_poll_period(&st_Sched)) {
+			// 늘어난 주기로 예약된 state 처리를 앞당김
+			osal_start_timerEx(main_taskID, sched_state, sched_poll_period(&st_Sched));
+		}
+		osal_start_timerEx(main_taskID, EVT_ADC_SAMPLE, sched_adc_period(&st_Sched));
+
+		if (gu16CurState == STATE_IN_KIOSK_CHGING && chg_term_update()) {
+			// 충전 완료, 1초 state 주기를 기다리지 않고 바로 처리
+			osal_stop_timerEx(main_taskID, STATE_IN_KIOSK_CHGING);
+			osal_set_event(main_taskID, STATE_IN_KIOSK_CHGING);
+		}
+		return (events ^ EVT_ADC_SAMPLE);
+	}
+
+	if (events & EVT_TEMP_READ) {
+		// 온도는 cache로만 읽으므로 I2C 통신은 여기서 주기당 한번
+		temp_service(osal_GetSystemClock());
+		if (!(ctrl_flags.abnormal & ERR_TEMP_OVER)) {
+			if (read_temperature() >= TEMP_OVER) {
+				// OS pin이 배선되지 않은 보드에서도 polling 값으로 과열 차단
+				charge_disable();
+				discharge_disable();
+				osal_set_event(main_taskID, EVT_TEMP_ALERT);
+			}
+		}
+		else if (!temp_alert_active() && read_temperature() < TEMP_OVER_HYST) {
+			// OS 해제 및 T_HYST 아래, 충/방전은 state machine에서 다시 판단
+			ctrl_flags.abnormal &= ~ERR_TEMP_OVER;
+		}
+		return (events ^ EVT_TEMP_READ);
+	}
+
+	if (events & EVT_TEMP_ALERT) {
+		// 과열 기록은 OS가 해제될때까지 한번만
+		if (!(ctrl_flags.abnormal & ERR_TEMP_OVER)) {
+			ctrl_flags.abnormal |= ERR_TEMP_OVER;
+			temp_service(osal_GetSystemClock());
+			set_log_data(LOG_EVT_OVER_TEMP, (uint16)read_temperature());
+		}
+		return (events ^ EVT_TEMP_ALERT);
+	}
+
+	if (events & EVT_CABLE_CHECK) {
+		// PMIC 응답 대기 중이면 다시 예약됨, 끝나면 cable_check_done이 불림
+		cable_check_service();
+		return (events ^ EVT_CABLE_CHECK);
+	}
+
+	if (events & EVT_LOG_FLUSH) {
+		// ring별 RAM 버퍼의 로그를 나누어 플래시에 기록, 남은 로그가 있으면 다시 예약
+		log_remain = 0;
+		for (i = 0; i < LOG_RING_CNT; i++) {
+			log_remain |= log_stage_flush(pst_LogRings[i], LOG_FLUSH_BURST);
+		}
+		if (log_remain) {
+			osal_start_timerEx(main_taskID, EVT_LOG_FLUSH, LOG_FLUSH_DELAY);
+		}
+		// 페이지를 사용했을 수 있으므로 다음 페이지 미리 지우기 예약
+		if (!osal_get_timeoutEx(main_taskID, EVT_LOG_ERASE)) {
+			osal_start_timerEx(main_taskID, EVT_LOG_ERASE, LOG_ERASE_DELAY);
+		}
+		return (events ^ EVT_LOG_FLUSH);
+	}
+
+	if (events & EVT_LOG_ERASE) {
+		// 충전 전류 측정, 키오스크 통신중에는 페이지 지우기(약 20ms)를 미룸
+		if (!chk_idle_state(gu16CurState)) {
+			osal_start_timerEx(main_taskID, EVT_LOG_ERASE, LOG_ERASE_RETRY);
+		}
+		// ring을 하나씩 돌아가며 처리하여 이벤트당 페이지 지우기는 최대 1회로 유지
+		else if (log_pre_erase(pst_LogRings[erase_ring]) || ++erase_ring < LOG_RING_CNT) {
+			osal_start_timerEx(main_taskID, EVT_LOG_ERASE, LOG_ERASE_DELAY);
+		}
+		else {
+			erase_ring = 0;
+		}
+		return (events ^ EVT_LOG_ERASE);
+	}
+
+	gu16CurState = events;
+	sched_set_profile(&st_Sched, state_sched_profile(events));
 
 	switch(events) {
 		case STATE_BOOT :
@@ -751,7 +1000,7 @@ uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 		case STATE_IN_KIOSK :
 		case STATE_IN_KIOSK_CHRGED :
 			log_ext_volt();
-			next_state_dly = 100; //0.1초마다 외부 전압 측정
+			next_state_dly = NEXT_DLY_SCHED; //외부 전압이 안정되면 0.1초 ~ 0.8초마다
 			if (chk_ext_volt_zero()) { // 키오스크에 있으면서 외부 전압이 0으로 검출
 				next_state = STATE_IN_KIOSK_EXT_VOLT_ZERO;
 				//next_state_dly = 100; // 0.1초마다 
@@ -759,7 +1008,7 @@ uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 			else if (chk_blz_conn()) { // 키오스크에 있으면서, 대여안된 상태에서 빌리지 코넥터가 빠짐
 				// 나중에 콜백 함수로 바꿔서, 한 번이라도 코넥터가 빠지면 검출 되도록..
 			}
-			else if (chk_ext_volt_chg()) {
+			else if (chk_ext_volt_chg() && chk_recharge()) {
 				// 충전 전압 상태
 				reset_log_ext_volt();
 				giChgingCnt = 0;
@@ -776,7 +1025,7 @@ uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 					case EXT_MIN_V : // 충전 전압, 허용되지 않은 상태천이.
 						reset_log_ext_volt();
 						giChgingCnt = 0;
-						next_state = STATE_IN_KIOSK_CHGING;
+						next_state = chk_recharge() ? STATE_IN_KIOSK_CHGING : STATE_IN_KIOSK_CHRGED;
 						break;
 					case EXT_COMM_V : // 통신 전압
 						reset_log_ext_volt();
@@ -792,7 +1041,7 @@ uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 					do_enable_usb_a();
 					do_enable_blz_conn();
 					reset_log_ext_volt();
-					next_state = STATE_IN_KIOSK_EXT_VOLT_ZERO;
+					next_state = STATE_OUT_KIOSK;
 				}
 			}
 			next_state_dly = 100; // 0.1초마다 
@@ -816,13 +1065,20 @@ uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 					save_charging_log();
 				}
 				if (!chk_charging()) {
-					//충전 종료
+					//충전 완료
 					stop_charging();
+					gu8ChgFull = TRUE;
+					//만충 전압으로 self-calibration, outlier로 판정된 측정값은 무시하고 기존 보정값 유지
+					if (!calib_update_self(read_adc_sampling(10, READ_BATT_SIDE))) {
+						ctrl_flags.self_calib = 1;
+					}
+					batt_soc_full(&batt_status);
 					next_state = STATE_IN_KIOSK_COMM_CHGING_LOG;
 				}
 			}
 			else if (chk_ext_volt_zero()) {
 				stop_charging();
+				set_log_data(LOG_EVT_EXT_V_LOSS, 0);
 				next_state_dly = 100; // 0.1초마다 
 				next_state = STATE_IN_KIOSK_EXT_VOLT_ZERO;
 			}
@@ -869,7 +1125,7 @@ uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 				}
 				else {
 					//사용자 손에서, 방전 대기 중
-					next_state_dly = 1000; // 1초마다 
+					next_state_dly = NEXT_DLY_SCHED; // 0.25초 ~ 4초마다
 				}
 			}
 
@@ -884,11 +1140,13 @@ uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 			} 
 			else if (!chk_chargeable()) { // 방전 가능한 상태가 아니면,
 				do_disable_usb_a(); // USB_A 코넥터를 비활성화
+				stop_discharging();
 				next_state = STATE_OUT_KIOSK;
 				next_state_dly = 1000; // 1초 후
 			}
 			else if (!chk_discharging()) { // 방전 상태가 아니면
 				do_enable_blz_conn();
+				stop_discharging();
 				next_state = STATE_OUT_KIOSK;
 			}
 			else { // 계속 방전 중
@@ -905,11 +1163,13 @@ uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 			}
 			else if (!chk_chargeable()) { // 방전 가능한 상태가 아니면,
 				do_disable_blz_conn(); // 빌리지 코넥터를 비활성화
+				stop_discharging();
 				next_state = STATE_OUT_KIOSK;
 				next_state_dly = 1000; // 1초 후
 			}
 			else if (!chk_discharging()) { // 방전 상태가 아니면
 				do_enable_usb_a();
+				stop_discharging();
 				next_state = STATE_OUT_KIOSK;
 			}
 			else { // 계속 방전 중
@@ -926,6 +1186,17 @@ uint16 BlzBat_ProcessEvent(uint8 task_id, uint16 events)
 			break;
 	} //switch(events)
 
+	if (next_state == events && !next_state_dly) {
+		// 상태 변화 없이 바로 다시 처리하면 OSAL을 계속 점유하므로 profile 주기로 예약
+		next_state_dly = NEXT_DLY_SCHED;
+	}
+
+	sched_state_pending = (next_state_dly == NEXT_DLY_SCHED);
+	if (sched_state_pending) {
+		sched_state = next_state;
+		next_state_dly = sched_poll_period(&st_Sched);
+	}
+
 	if (next_state_dly) {
 		osal_start_timerEx(main_taskID, next_state, next_state_dly);
 	}
@@ -951,11 +1222,9 @@ osal_mem_free(tx_buff);
 osal_start_timerEx(next_task, next_evt, 10);
 read_voltage(READ_EXT);
 read_voltage_sampling(10, READ_EXT);
-setup_calib_value(TRUE, search_self_calib());
-stroed_key_value(&st_LogAddr);
 transmit_data_stream(size, tx_buff);
 uart_disable();
 uart_enable();
-update_self_calibration(ctrl_flags.self_calib, read_adc_sampling(10, READ_BATT_SIDE));
+calib_update_self(read_adc_sampling(10, READ_BATT_SIDE));
 read_temperature();
 */
@@ -33,10 +33,51 @@
 
 #define DBG_EVT_A                0x1000
 
+/* ADC background sampler 주기 event, 변환만 시작하고 결과는 ADC 인터럽트에서 저장
+ * 주기는 state별 sched profile에 따라 ADC_SAMPLE_PERIOD ~ CC_MAX_DT 사이에서 바뀜 */
+#define EVT_ADC_SAMPLE          0x0040
+#define NEXT_DLY_SCHED          0xFFFF  //next_state_dly, sched profile의 state 처리 주기 사용
+#define EXT_SETTLE_TICKS        150     //외부전압 판정 변경 후 최소 주기를 유지할 sampler tick 수
+
+/* sched 감시 신호 순서 */
+#define SCHED_SIG_EXT           0       //외부전압(mV)
+#define SCHED_SIG_CURR          1       //충/방전 전류(mA)
+#define SCHED_SIG_BATT          2       //배터리 전압(mV)
+#define SCHED_SIG_CNT           3
+
+/* 충전 완료 판정, STATE_IN_KIOSK_CHGING 중 EVT_ADC_SAMPLE마다 충전 전류를 검사
+ * 기준 근처에서는 sched가 최소 주기(ADC_SAMPLE_PERIOD)를 유지하므로
+ * 약 1s(기준에서 멀면 최대 8s) 연속으로 기준 이하면 완료.
+ * sequential 전류 측정(잡음 약 10mA rms)에서 실제보다 10mA 이상 낮게 읽히는 연속 tick은 최대 92회
+ * (host_test/adc_isr의 term run)이므로 기준보다 10mA 이상 높은 충전 전류로는 완료되지 않음 */
+#define CHG_TERM_CURR_MA        300 //충전 완료 전류(mA)
+#define CHG_TERM_CNT            100 //연속 판정 횟수
+#define CHG_RESTART_MV          4100 //만충 후 다시 충전을 시작하는 배터리 전압(mV)
+
+/* LM75 온도 cache 갱신 event, 주기 TEMP_PERIOD */
+#define EVT_TEMP_READ           0x0020
+/* LM75 OS 인터럽트 event, 충/방전은 ISR에서 이미 차단됨 */
+#define EVT_TEMP_ALERT          0x0800
+
+/* 빌리지 케이블 검사 event, 검사중 CABLE_POLL_MS마다 PMIC 응답 확인 */
+#define EVT_CABLE_CHECK         0x1000
+
+/* log RAM buffer flush event */
+#define EVT_LOG_FLUSH           0x4000
+#define LOG_FLUSH_DELAY         500 //로그 기록 후 플래시에 옮기기까지 대기시간(ms)
+
+/* log page background erase event */
+#define EVT_LOG_ERASE           0x2000
+#define LOG_ERASE_DELAY         50   //다음 페이지 지우기까지 대기시간(ms)
+#define LOG_ERASE_RETRY         1000 //시간에 민감한 상태일때 재시도 간격(ms)
+
 #define PARAM_LOGADDR       0x01
 #define PARAM_LOGDATA       0x02
 #define PARAM_CTRL_FLAG     0x03
 #define PARAM_EVT_VALS      0x04
+#define PARAM_LOG_CHG       0x05    //충전 텔레메트리 로그 ring 주소
+#define PARAM_LOG_EVT       0x06    //이상 이벤트 로그 ring 주소
+#define PARAM_BATT_INFO     0x07    //배터리 상태, coulomb counter 값
 
 typedef enum _TASK_LOCATION {
 	/*
@@ -0,0 +1,121 @@
+#include "sched_mgr.h"
+
+/**
+ * @fn sched_period
+ * @brief min << backoff, max를 넘으면 max
+ */
+static uint16 sched_period(uint16 min_ms, uint16 max_ms, uint8 backoff)
+{
+    uint32 period = (uint32)min_ms << backoff;
+
+    if (period > max_ms) {
+        return max_ms;
+    }
+
+    return (uint16)period;
+}
+
+/**
+ * @fn sched_sig_active
+ * @brief 신호가 빠르게 변하거나 판정 기준 근처인지 확인하고 이전 값을 갱신
+ */
+static uint8 sched_sig_active(sched_sig_t *apst_sig, uint16 value, uint8 primed)
+{
+    uint8 i, active = FALSE;
+    uint16 diff;
+
+    if (primed) {
+        diff = (value > apst_sig->last) ? value - apst_sig->last : apst_sig->last - value;
+        if (diff >= apst_sig->delta) {
+            active = TRUE;
+        }
+    }
+    apst_sig->last = value;
+
+    for (i = 0; i < apst_sig->th_cnt && !active; i++) {
+        diff = (value > apst_sig->p_th[i]) ? value - apst_sig->p_th[i] : apst_sig->p_th[i] - value;
+        if (diff <= apst_sig->margin) {
+            active = TRUE;
+        }
+    }
+
+    return active;
+}
+
+/**
+ * @fn sched_init
+ * @brief 감시 신호 목록과 시작 profile 설정, 최소 주기부터 시작
+ */
+void sched_init(sched_mgr_t *apst_sched, sched_sig_t *apst_sigs, uint8 sig_cnt,
+                const sched_profile_t *apst_profile)
+{
+    apst_sched->p_sigs = apst_sigs;
+    apst_sched->sig_cnt = sig_cnt;
+    apst_sched->p_profile = apst_profile;
+    apst_sched->backoff = 0;
+    apst_sched->primed = FALSE;
+}
+
+/**
+ * @fn sched_set_profile
+ * @brief state 변경시 profile 교체, 상태 천이 직후에는 최소 주기로 다시 시작
+ *
+ * @return TRUE: profile이 바뀜
+ */
+uint8 sched_set_profile(sched_mgr_t *apst_sched, const sched_profile_t *apst_profile)
+{
+    if (apst_sched->p_profile == apst_profile) {
+        return FALSE;
+    }
+
+    apst_sched->p_profile = apst_profile;
+    apst_sched->backoff = 0;
+    return TRUE;
+}
+
+/**
+ * @fn sched_update
+ * @brief 감시 신호 값으로 backoff를 갱신, EVT_ADC_SAMPLE마다 호출
+ *
+ * @param ap_values sig_cnt개의 현재 값, p_sigs와 같은 순서
+ * @param hold_fast TRUE면 신호와 관계없이 최소 주기 유지(판정 직후 등)
+ * @return TRUE: 늘어나 있던 주기가 최소 주기로 돌아감, 이미 예약된 처리를 앞당겨야 함
+ */
+uint8 sched_update(sched_mgr_t *apst_sched, const uint16 *ap_values, uint8 hold_fast)
+{
+    uint8 i, active = hold_fast;
+    uint8 prev = apst_sched->backoff;
+    const sched_profile_t *p_prof = apst_sched->p_profile;
+
+    //모든 신호의 last를 갱신해야 하므로 중간에 멈추지 않음
+    for (i = 0; i < apst_sched->sig_cnt; i++) {
+        active |= sched_sig_active(&apst_sched->p_sigs[i], ap_values[i], apst_sched->primed);
+    }
+    apst_sched->primed = TRUE;
+
+    if (active) {
+        apst_sched->backoff = 0;
+        return (prev != 0);
+    }
+
+    //두 주기가 모두 max에 도달하면 더 늘리지 않음
+    if (apst_sched->backoff < SCHED_BACKOFF_MAX
+        && (((uint32)p_prof->adc_min << apst_sched->backoff) < p_prof->adc_max
+            || ((uint32)p_prof->poll_min << apst_sched->backoff) < p_prof->poll_max)) {
+        apst_sched->backoff++;
+    }
+
+    return FALSE;
+}
+
+uint16 sched_adc_period(sched_mgr_t *apst_sched)
+{
+    return sched_period(apst_sched->p_profile->adc_min, apst_sched->p_profile->adc_max,
+                        apst_sched->backoff);
+}
+
+uint16 sched_poll_period(sched_mgr_t *apst_sched)
+{
+    return sched_period(apst_sched->p_profile->poll_min, apst_sched->p_profile->poll_max,
+                        apst_sched->backoff);
+}
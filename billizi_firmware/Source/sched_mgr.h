@@ -0,0 +1,42 @@
+#ifndef __SCHED_MANAGER__
+#define __SCHED_MANAGER__
+
+#include "hal_types.h"
+
+/* adaptive sampling schedule
+ * 감시 신호가 판정 기준에서 멀고 변화가 없으면 주기를 2배씩 늘리고(backoff),
+ * 한 신호라도 tick간 변화가 delta 이상이거나 기준까지 margin 이내면 바로 최소 주기로 돌아감.
+ * 주기는 state별 profile의 min << backoff, max에서 멈춤. */
+#define SCHED_BACKOFF_MAX   8
+
+typedef struct _SCHED_PROFILE {
+    uint16 adc_min;     //EVT_ADC_SAMPLE 최소 주기(ms)
+    uint16 adc_max;     //EVT_ADC_SAMPLE 최대 주기(ms)
+    uint16 poll_min;    //state 처리 최소 주기(ms)
+    uint16 poll_max;    //state 처리 최대 주기(ms)
+}sched_profile_t;
+
+typedef struct _SCHED_SIG {
+    uint16 delta;           //tick간 변화가 이 이상이면 최소 주기
+    uint16 margin;          //판정 기준까지 거리가 이 이하면 최소 주기
+    const uint16 *p_th;     //판정 기준 목록
+    uint8 th_cnt;
+    uint16 last;            //이전 tick의 값
+}sched_sig_t;
+
+typedef struct _SCHED_MGR {
+    const sched_profile_t *p_profile;
+    sched_sig_t *p_sigs;
+    uint8 sig_cnt;
+    uint8 backoff;          //주기 = min << backoff
+    uint8 primed;           //p_sigs의 last가 유효함
+}sched_mgr_t;
+
+void sched_init(sched_mgr_t *apst_sched, sched_sig_t *apst_sigs, uint8 sig_cnt,
+                const sched_profile_t *apst_profile);
+uint8 sched_set_profile(sched_mgr_t *apst_sched, const sched_profile_t *apst_profile);
+uint8 sched_update(sched_mgr_t *apst_sched, const uint16 *ap_values, uint8 hold_fast);
+uint16 sched_adc_period(sched_mgr_t *apst_sched);
+uint16 sched_poll_period(sched_mgr_t *apst_sched);
+
+#endif
@@ -8,11 +8,42 @@ static uint8 rx_tail;
 static uint16 debug_vals;
 static uint8 gucChgState = 0;
 
+//UART 로그 검색 상태
+static log_query_t uart_qry;
+static uint8 uart_qry_ring = LOG_RING_CNT;
+
+static uint32 parse_hex(uint8 *p_str, uint8 len)
+{
+    uint32 value = 0;
+    uint8 i;
+
+    for (i = 0; i < len; i++) {
+        value <<= 4;
+        if (p_str[i] >= '0' && p_str[i] <= '9') {
+            value |= p_str[i] - '0';
+        } else if (p_str[i] >= 'A' && p_str[i] <= 'F') {
+            value |= p_str[i] - 'A' + 10;
+        } else if (p_str[i] >= 'a' && p_str[i] <= 'f') {
+            value |= p_str[i] - 'a' + 10;
+        }
+    }
+
+    return value;
+}
+
 void cb_rx_PacketParser( uint8 port, uint8 events )
 {
     (void)port; //unused input parameters
     uint8 num_bytes = Hal_UART_RxBufLen(NPI_UART_PORT);
     float tmp = 0;
+    uint32 log_records, flash_writes;
+    uint16 erase_avoided, erase_inline;
+    uint16 wear_hist[WEAR_HIST_BINS];
+    uint32 wear_min, wear_max;
+    flash_stats_t flash_stats;
+    uint8 *qry_packet;
+    uint8 qry_size;
+    uint8 i;
 
     if(num_bytes) {
         //print_uart("VALID\r\n");
@@ -36,12 +67,12 @@ void cb_rx_PacketParser( uint8 port, uint8 events )
             case 0x31: // '1'
                 get_gparam_calib(&tmp);
                 //print_uart("%04X\r\n", read_adc_sampling(10, READ_BATT_SIDE));
-                print_uart("%.2f[V], ", read_voltage(READ_BATT_SIDE));
-                print_uart("%.2f[V], ", read_voltage(READ_INDUCTOR_SIDE));
+                print_uart("%u[mV], ", read_voltage(READ_BATT_SIDE));
+                print_uart("%u[mV], ", read_voltage(READ_INDUCTOR_SIDE));
                 print_uart("%.2f\r\n", tmp);
                 break;
             case 0x32: //'2'
-                print_uart("%.2f[V]\r\n", read_voltage(READ_EXT));
+                print_uart("%u[mV]\r\n", read_voltage(READ_EXT));
                 // print_uart("CONN_EN-");
                 // if (EN_CONN_RETR) {
                 //     print_uart("0");
@@ -65,6 +96,29 @@ void cb_rx_PacketParser( uint8 port, uint8 events )
                 // }
                 // print_uart("\r\n");
                 break;
+            case 0x34: // '4'
+                get_log_write_stats(&log_records, &flash_writes);
+                print_uart("%lu/%lu\r\n", flash_writes, log_records);
+                break;
+            case 0x35: // '5'
+                get_log_erase_stats(&erase_avoided, &erase_inline);
+                print_uart("ERS-%u/%u\r\n", erase_avoided, erase_inline);
+                break;
+            case 0x36: // '6'
+                //페이지 지우기 횟수 분포: 로그 영역 구간별 페이지 수, 설정 페이지 A/B
+                get_log_wear_histogram(wear_hist, WEAR_HIST_BINS, &wear_min, &wear_max);
+                print_uart("WEAR-%lu~%lu:", wear_min, wear_max);
+                for (i = 0; i < WEAR_HIST_BINS; i++) {
+                    print_uart(" %u", wear_hist[i]);
+                }
+                print_uart("\r\nSET-%lu/%lu\r\n", get_page_wear(ADDR_2_PAGE(FLADDR_SETTING_A)),
+                           get_page_wear(ADDR_2_PAGE(FLADDR_SETTING_B)));
+                break;
+            case 0x37: // '7'
+                //플래시 읽기 통계: bank 매핑 횟수/읽은 word 수
+                get_flash_stats(&flash_stats);
+                print_uart("RD-%lu/%lu\r\n", flash_stats.read_calls, flash_stats.read_words);
+                break;
             // case 0x34:
             //     print_uart("STATUS-");
             //     if (RETR_CABLE_STATUS) {
@@ -74,6 +128,21 @@ void cb_rx_PacketParser( uint8 port, uint8 events )
             //     }
             //     print_uart("\r\n");
             //     break;
+        case 'Q' :
+          //로그 검색 시작, 첫번째 결과를 바로 전송
+          if (rx_tail <= QUERY_CMD_LEN) {
+              break;
+          }
+          uart_qry_ring = (uint8)parse_hex(rx_buff + 1, 1);
+          log_query_begin(&uart_qry, (uint16)parse_hex(rx_buff + 2, 4),
+                          parse_hex(rx_buff + 6, 6), parse_hex(rx_buff + 12, 6));
+          /* fall through */
+        case 'N' :
+          //로그 검색 다음 결과
+          qry_packet = get_query_packet(uart_qry_ring, &uart_qry, &qry_size);
+          transmit_data_stream(qry_size, qry_packet);
+          osal_mem_free(qry_packet);
+          break;
         case 'r' :
         case 'R' :
         case 'v' :
@@ -191,6 +260,22 @@ void print_uart(char *tx_data, ...)
 //     print_uart("\r\n");
 // }
 
+// coulomb counter 값(soc, 남은 용량, 누적 충/방전량)을 packet에 채움, 11byte
+static uint8 fill_soc_data(uint8 *p_data, batt_info_t *apst_BattStatus)
+{
+    uint8 data_offset = 0;
+
+    p_data[data_offset++] = apst_BattStatus->soc;
+    VOID osal_memcpy(p_data + data_offset, (uint8*)&apst_BattStatus->remain_mah, sizeof(uint16));
+    data_offset += sizeof(uint16);
+    VOID osal_memcpy(p_data + data_offset, (uint8*)&apst_BattStatus->chg_mah, sizeof(uint32));
+    data_offset += sizeof(uint32);
+    VOID osal_memcpy(p_data + data_offset, (uint8*)&apst_BattStatus->dischg_mah, sizeof(uint32));
+    data_offset += sizeof(uint32);
+
+    return data_offset;
+}
+
 uint8 *get_head_packet(Control_flag_t *apst_flags, batt_info_t *apst_BattStatus, uint16 log_cnt)
 {
     uint8 *comm_data;
@@ -206,8 +291,8 @@ uint8 *get_head_packet(Control_flag_t *apst_flags, batt_info_t *apst_BattStatus,
     LL_ReadBDADDR(comm_data + data_offset);         //8
     data_offset += 6;
 
-    //convert to uint16 types, (unit convert to V->mV)
-    ui16_tmpdata = (uint16)(apst_BattStatus->batt_v * 1000);    
+    //battery voltage [mV]
+    ui16_tmpdata = apst_BattStatus->batt_mv;
     VOID osal_memcpy(comm_data + data_offset, (uint8*)&ui16_tmpdata, sizeof(uint16));   //10
     data_offset += sizeof(uint16);
 
@@ -231,41 +316,48 @@ uint8 *get_head_packet(Control_flag_t *apst_flags, batt_info_t *apst_BattStatus,
     VOID osal_memcpy(comm_data + data_offset, (uint8*)&log_cnt, sizeof(uint16));        //16
     data_offset += sizeof(uint16);
 
+    //state of charge, 남은 용량, 누적 충/방전량
+    data_offset += fill_soc_data(comm_data + data_offset, apst_BattStatus);         //27
+
     //packet length
     //comm_data[data_offset] = data_offset;           //17
 
     return comm_data;
 }
 
-uint8 *get_log_packet(log_addr_t *apst_addr) 
+// coulomb counter 값만 담은 packet(BATT_SOC_LEN), BLE 조회용
+uint8 *get_soc_packet(void)
 {
     uint8 *comm_data;
-    uint8 data_offset = 0;
-    uint8 *tmp_data;
+    batt_info_t batt_info;
 
-    log_data_t batt_log;
-    time_data_t time_stamp;
+    get_main_params(PARAM_BATT_INFO, &batt_info);
 
-    uint32 tmp_flash;
+    comm_data = osal_mem_alloc(sizeof(uint8) * BATT_SOC_LEN);
+    comm_data[0] = HEADER_SOC;
+    fill_soc_data(comm_data + 1, &batt_info);
 
-    comm_data = osal_mem_alloc(sizeof(uint8) * BATT_LOG_LEN);
-    read_flash(apst_addr->offset_addr, FLOPT_UINT32, &tmp_flash);
-    //print_uart("0x%04X, ", apst_addr->offset_addr);
-    //print_uart("0x%08lX\r\n", tmp_flash);
+    return comm_data;
+}
 
-    batt_log.data_all = tmp_flash;
-    apst_addr->offset_addr = LOGADDR_VALIDATION(apst_addr->offset_addr + 1);
+// 로그 1개를 키오스크/BLE 전송용 packet(BATT_LOG_LEN)으로 변환
+static uint8 *build_log_packet(uint16 log_id, log_data_t *apst_log, time_data_t *apst_time)
+{
+    uint8 *comm_data;
+    uint8 data_offset = 0;
+    uint8 *tmp_data;
+
+    comm_data = osal_mem_alloc(sizeof(uint8) * BATT_LOG_LEN);
 
     comm_data[data_offset++] = HEADER_LOG;  //1
 
     //log id
-    apst_addr->log_cnt++;
-    VOID osal_memcpy(comm_data+data_offset, (uint8*)&apst_addr->log_cnt, sizeof(uint16));   //3
+    VOID osal_memcpy(comm_data+data_offset, (uint8*)&log_id, sizeof(uint16));   //3
     data_offset += sizeof(uint16);
     
     //log type
-    tmp_data = (uint8*)&batt_log.data_all;     //4
-    comm_data[data_offset++] = batt_log.log_type;
+    tmp_data = (uint8*)&apst_log->data_all;     //4
+    comm_data[data_offset++] = apst_log->log_type;
 
     //data type: 어떤 데이터인지 알려줌 (전압, 전류, 충격, 온도)
     comm_data[data_offset++] = tmp_data[3];     //5
@@ -275,18 +367,56 @@ uint8 *get_log_packet(log_addr_t *apst_addr)
     comm_data[data_offset++] = tmp_data[2];     //7
 
     //state machine information
-    comm_data[data_offset++] = batt_log.log_evt; //8
+    comm_data[data_offset++] = apst_log->log_evt; //8
 
     //time stamp
-    read_flash(apst_addr->offset_addr, FLOPT_UINT32, &time_stamp.data_all);
-    apst_addr->offset_addr = LOGADDR_VALIDATION(apst_addr->offset_addr + 1);
-    tmp_data = (uint8*)&time_stamp;
+    tmp_data = (uint8*)apst_time;
     if(tmp_data[0] == LOG_HEAD_TIME) {
         comm_data[data_offset++] = tmp_data[1];     //9
         comm_data[data_offset++] = tmp_data[2];     //10
         comm_data[data_offset++] = tmp_data[3];     //11
     }
 
+    return comm_data;
+}
+
+uint8 *get_log_packet(log_addr_t *apst_addr) 
+{
+    log_data_t batt_log;
+    time_data_t time_stamp;
+
+    //1word 로그를 읽어 절대 시각을 복원, offset_addr는 다음 로그로 이동
+    batt_log.data_all = 0;
+    time_stamp.data_all = 0;
+    log_read_record(apst_addr, &batt_log, &time_stamp);
+    //print_uart("0x%04X, ", apst_addr->offset_addr);
+
+    apst_addr->log_cnt++;
+
+    return build_log_packet(apst_addr->log_cnt, &batt_log, &time_stamp);
+}
+
+// 검색 조건에 맞는 다음 로그의 packet, 더 이상 없다면 HEADER_QUERY_END 1byte packet
+// UART(키오스크)와 BLE에서 공통으로 사용
+uint8 *get_query_packet(uint8 ring, log_query_t *apst_qry, uint8 *p_size)
+{
+    static const uint8 ring_params[LOG_RING_CNT] = {PARAM_LOG_CHG, PARAM_LOGADDR, PARAM_LOG_EVT};
+    uint8 *comm_data;
+    log_addr_t log_addr;
+    log_data_t batt_log;
+    time_data_t time_stamp;
+
+    if (ring < LOG_RING_CNT) {
+        get_main_params(ring_params[ring], &log_addr);
+        if (!log_query(&log_addr, apst_qry, &batt_log, &time_stamp)) {
+            *p_size = BATT_LOG_LEN;
+            return build_log_packet(apst_qry->match_cnt, &batt_log, &time_stamp);
+        }
+    }
+
+    comm_data = osal_mem_alloc(sizeof(uint8));
+    comm_data[0] = HEADER_QUERY_END;
+    *p_size = 1;
 
     return comm_data;
 }
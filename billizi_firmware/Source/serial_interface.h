@@ -10,14 +10,22 @@
 #include "gpio_interface.h"
 #include "hw_mgr.h"
 #include "flash_interface.h"
+#include "log_mgr.h"
 
-#define RX_BUFF_SIZE    20
+#define RX_BUFF_SIZE    32      //QUERY_CMD_LEN + CRLF 보다 여유있게
 #define INIT_LEN        8
-#define BATT_INFO_LEN   16
+#define BATT_INFO_LEN   27
+#define BATT_SOC_LEN    12
 #define BATT_LOG_LEN    11
+#define WEAR_HIST_BINS  8
 
 #define HEADER_INFO     0x10
 #define HEADER_LOG      0x20
+#define HEADER_QUERY_END 0x30   //로그 검색 종료, 1byte packet
+#define HEADER_SOC      0x40    //coulomb counter 값, BATT_SOC_LEN
+
+//로그 검색 명령: 'Q' ring(1) type_mask(4) t_from(6) t_to(6), 16진수 문자
+#define QUERY_CMD_LEN   18
 
 #define PACKET_START    0x00
 #define PACKET_END      0xFF
@@ -40,6 +48,8 @@ void transmit_data_stream(uint8 tx_len, uint8 *tx_data);
 
 uint8 *get_head_packet(Control_flag_t *apst_flags, batt_info_t *apst_BattStatus, uint16 log_cnt);
 uint8 *get_log_packet(log_addr_t *apst_addr);
+uint8 *get_query_packet(uint8 ring, log_query_t *apst_qry, uint8 *p_size);
+uint8 *get_soc_packet(void);
 
 void uart_init(npiCBack_t npiCback);
 void print_hex(uint8 *tx_buff, uint8 size);
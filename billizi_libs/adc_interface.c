@@ -1,9 +1,34 @@
 #include "adc_interface.h"
-
-static float convert_voltage(uint16 adc_org, adc_option_t adc_opt);
-float g_calib;
-
-void open_adc_driver(adc_option_t adc_opt)
+#include "flash_interface.h"
+
+static uint16 convert_voltage(uint16 adc_org, adc_option_t adc_opt);
+static calib_mgr_t st_calib;
+static ext_class_t st_ext_class;
+
+//background sampler 상태, ring buffer는 ADC ISR에서 갱신됨
+static adc_ring_t adc_rings[ADC_RING_CNT];
+static adc_filter_t adc_filters[ADC_RING_CNT] = {
+    {ADC_SHUNT_OS_BITS, ADC_SHUNT_IIR_SHIFT, ADC_SHUNT_BURST, 0, 0, 0, 0},  //READ_BATT_SIDE
+    {ADC_SHUNT_OS_BITS, ADC_SHUNT_IIR_SHIFT, ADC_SHUNT_BURST, 0, 0, 0, 0},  //READ_INDUCTOR_SIDE
+    {ADC_EXT_OS_BITS, ADC_EXT_IIR_SHIFT, ADC_EXT_BURST, 0, 0, 0, 0}         //READ_EXT
+};
+//interleave 전류 측정의 차동 filter, 입력은 ABBA 1쌍의 (I1 + I2) - (B1 + B2) + ADC_DIFF_OFFSET
+static adc_filter_t diff_filter = {ADC_DIFF_OS_BITS, ADC_DIFF_IIR_SHIFT, 1, 0, 0, 0, 0};
+static int16 samp_diff;
+static uint8 samp_diff_cnt;
+static volatile uint8 samp_step = ADC_SEQ_IDLE;
+static uint8 samp_active = FALSE;
+static uint8 samp_interleave = FALSE;
+
+//한 주기의 변환 순서, samp_build_seq에서 filter 설정으로 만듦
+static uint8 samp_seq[ADC_SEQ_MAX];
+static uint8 samp_len;
+
+/**
+ * @fn set_adc_drive
+ * @brief shunt 저항의 측정할 쪽 IO를 켬, 안정화 대기 없음(ISR에서 사용)
+ */
+static void set_adc_drive(adc_option_t adc_opt)
 {
     switch(adc_opt) {
         case READ_BATT_SIDE:
@@ -18,6 +43,11 @@ void open_adc_driver(adc_option_t adc_opt)
             //do not working option
             break;
     }
+}
+
+void open_adc_driver(adc_option_t adc_opt)
+{
+    set_adc_drive(adc_opt);
     if (adc_opt != READ_EXT) {
         delay_us(50);
     }
@@ -31,33 +61,634 @@ void close_adc_driver()
 
 void get_gparam_calib(void *p_value) 
 {
-    *((float *)p_value) = g_calib;
+    *((float *)p_value) = (float)st_calib.batt_q / BATT_MV_Q;
 }
 
+/**
+ * @fn setup_calib_value
+ * @brief 보정 adc 값으로 배터리 전압 변환 상수(batt_q)를 계산하여 RAM에 저장
+ *        보정값이 바뀔때만 호출되므로 변환시에는 곱셈과 shift만 수행함.
+ * 
+ * @param calib_opt: self calibration=TRUE || reference calibration=FALSE
+ * @param calib_value: 보정 adc 값, 분압비의 2배를 넘는 보정은 무시하고 보정하지 않음
+ */
 void setup_calib_value(uint8 calib_opt, uint16 calib_value)
 {   
-    float adc_voltage;
+    uint32 num = calib_opt ? CALIB_SELF_NUM : CALIB_REF_NUM;
+
+    if (calib_value == 0 || num / calib_value > (BATT_MV_Q << 1)) {
+        st_calib.mode = CALIB_NONE;
+        st_calib.calib_adc = 0;
+        st_calib.batt_q = BATT_MV_Q;
+        return;
+    }
+
+    st_calib.mode = calib_opt ? CALIB_SELF : CALIB_REF;
+    st_calib.calib_adc = calib_value;
+    st_calib.batt_q = (num + (calib_value >> 1)) / calib_value;
+}
+
+/**
+ * @fn calib_hist_median
+ * @brief self-calibration 이력의 중앙값, 짝수개라면 가운데 두 값의 평균
+ */
+static uint16 calib_hist_median(void)
+{
+    uint16 sorted[CALIB_HIST_CNT];
+    uint16 tmp;
+    uint8 i, j;
+
+    for (i = 0; i < st_calib.hist_cnt; i++) {
+        tmp = st_calib.hist[i];
+        for (j = i; j > 0 && sorted[j - 1] > tmp; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = tmp;
+    }
+
+    i = st_calib.hist_cnt >> 1;
+    if (st_calib.hist_cnt & 1) {
+        return sorted[i];
+    }
+
+    return (uint16)(((uint32)sorted[i - 1] + sorted[i]) >> 1);
+}
+
+/**
+ * @fn calib_hist_push
+ * @brief self-calibration 이력에 값을 추가, 가득차면 가장 오래된 값을 덮어씀
+ */
+static void calib_hist_push(uint16 adc_value)
+{
+    st_calib.hist[st_calib.hist_idx] = adc_value;
+    st_calib.hist_idx = (st_calib.hist_idx + 1) % CALIB_HIST_CNT;
+    if (st_calib.hist_cnt < CALIB_HIST_CNT) {
+        st_calib.hist_cnt++;
+    }
+}
+
+/**
+ * @fn calib_load
+ * @brief 부팅시 설정 저장소(RAM index)의 보정값으로 보정 배율과 이력을 초기화
+ *        settings_init 이후에 호출해야 함.
+ * 
+ * @return CALIB_NONE(보정값 없음, 공장 초기화 필요) || CALIB_REF || CALIB_SELF
+ */
+uint8 calib_load(void)
+{
+    uint16 calib_ref;
+    uint16 calib_value;
+
+    st_calib.hist_cnt = 0;
+    st_calib.hist_idx = 0;
+    st_calib.reject_adc = 0;
+    setup_calib_value(FALSE, 0);
+
+    if (!settings_get(SET_KEY_CALIB_REF, &calib_ref)) {
+        return CALIB_NONE;
+    }
+
+    if (calib_ref != 0) {
+        setup_calib_value(FALSE, calib_ref);
+    } else if (settings_get(SET_KEY_CALIB_SELF, &calib_value)) {
+        setup_calib_value(TRUE, calib_value);
+        if (st_calib.mode == CALIB_SELF) {
+            calib_hist_push(calib_value);
+        }
+    }
 
-    adc_voltage = calib_value * REF125_UNIT * BATT_RATIO_V;
-    if (calib_opt) {
-        /* set self calibration */
-        g_calib = MAX_BATT_V/adc_voltage;    
-    }else {
-        /* set reference voltage calibration */
-        g_calib = BATT_REF_V/adc_voltage;    
+    return st_calib.mode;
+}
+
+/**
+ * @fn calib_update_self
+ * @brief 만충시 측정한 배터리 adc 값으로 self-calibration 갱신
+ *        이력의 중앙값과 CALIB_OUTLIER_ADC 이상 차이나는 측정값은 반영하지 않음.
+ *        단, 연속된 두 outlier가 서로 가깝다면 실제 변화로 보고 이력을 새로 시작함.
+ *        반영된 값은 설정 저장소에 바로 기록되며 reference calibration은 해제됨.
+ * 
+ * @return 반영=0 || outlier로 무시=1 || 플래시 기록 실패=2
+ */
+uint8 calib_update_self(uint16 adc_value)
+{
+    uint16 median;
+    uint16 diff;
+
+    if (st_calib.hist_cnt) {
+        median = calib_hist_median();
+        diff = (adc_value > median) ? adc_value - median : median - adc_value;
+        if (diff >= CALIB_OUTLIER_ADC) {
+            diff = (adc_value > st_calib.reject_adc) ? adc_value - st_calib.reject_adc
+                                                     : st_calib.reject_adc - adc_value;
+            if (!st_calib.reject_adc || diff >= CALIB_OUTLIER_ADC) {
+                st_calib.reject_adc = adc_value;
+                return 1;
+            }
+            st_calib.hist_cnt = 0;
+            st_calib.hist_idx = 0;
+        }
     }
+    st_calib.reject_adc = 0;
+
+    if (st_calib.mode == CALIB_REF && settings_set(SET_KEY_CALIB_REF, 0)) {
+        return 2;
+    }
+    calib_hist_push(adc_value);
+    setup_calib_value(TRUE, adc_value);
+
+    return settings_set(SET_KEY_CALIB_SELF, adc_value) ? 2 : 0;
+}
+
+/**
+ * @fn calib_get_adc
+ * @brief 현재 사용중인 보정 adc 값, 보정되지 않았다면 0
+ */
+uint16 calib_get_adc(void)
+{
+    return st_calib.calib_adc;
 }
 
 void adc_init()
 {
-    g_calib = 0;
+    setup_calib_value(FALSE, 0);
 	HalAdcSetReference(HAL_ADC_REF_125V);
 }
 
+/**
+ * @fn adc_ring_push
+ * @brief channel의 ring buffer에 변환값을 추가
+ */
+static void adc_ring_push(adc_ring_t *apst_ring, uint16 adc_val)
+{
+    apst_ring->buf[apst_ring->idx] = adc_val;
+    apst_ring->idx = (apst_ring->idx + 1) & (ADC_RING_SIZE - 1);
+}
+
+/**
+ * @fn adc_ring_fill
+ * @brief ring buffer 전체를 한 값으로 채움, sampler 시작 전 초기값
+ */
+static void adc_ring_fill(adc_ring_t *apst_ring, uint16 adc_val)
+{
+    uint8 i;
+
+    for (i = 0; i < ADC_RING_SIZE; i++) {
+        apst_ring->buf[i] = adc_val;
+    }
+    apst_ring->idx = 0;
+}
+
+/**
+ * @fn adc_decimate
+ * @brief 4^os_bits개 변환의 합계를 평균 << ADC_HR_SHIFT로 변환
+ *        합계는 2 * os_bits bit 증가하며 그중 os_bits bit가 유효 해상도임.
+ *        2 * os_bits <= ADC_HR_SHIFT이면 나머지 bit도 버리지 않으므로 반올림 오차가 없음
+ *        (차동 filter처럼 offset을 빼는 경우 반올림 bias가 그대로 남음)
+ */
+static uint32 adc_decimate(uint32 acc, uint8 os_bits)
+{
+    uint8 growth = os_bits << 1;
+
+    if (growth <= ADC_HR_SHIFT) {
+        return acc << (ADC_HR_SHIFT - growth);
+    }
+
+    growth -= ADC_HR_SHIFT;
+    return (acc + ((uint32)1 << (growth - 1))) >> growth;
+}
+
+/**
+ * @fn adc_filter_push
+ * @brief 변환값을 box filter에 합산, 4^os_bits개가 모이면 decimation 후 IIR을 거쳐 출력을 갱신
+ */
+static void adc_filter_push(adc_filter_t *apst_filt, uint16 adc_val)
+{
+    uint32 x;
+
+    apst_filt->acc += adc_val;
+    if (++apst_filt->cnt < ((uint16)1 << (apst_filt->os_bits << 1))) {
+        return;
+    }
+
+    x = adc_decimate(apst_filt->acc, apst_filt->os_bits);
+    apst_filt->acc = 0;
+    apst_filt->cnt = 0;
+
+    if (apst_filt->iir_shift) {
+        apst_filt->iir += x - (apst_filt->iir >> apst_filt->iir_shift);
+        apst_filt->out = apst_filt->iir >> apst_filt->iir_shift;
+    } else {
+        apst_filt->out = x;
+    }
+}
+
+/**
+ * @fn adc_filter_prime
+ * @brief filter 상태를 한 값(adc << ADC_HR_SHIFT)으로 초기화
+ */
+static void adc_filter_prime(adc_filter_t *apst_filt, uint32 hr_val)
+{
+    apst_filt->acc = 0;
+    apst_filt->cnt = 0;
+    apst_filt->out = hr_val;
+    apst_filt->iir = hr_val << apst_filt->iir_shift;
+}
+
+/**
+ * @fn samp_build_seq
+ * @brief filter의 burst 설정과 전류 측정 방식으로 한 주기의 변환 순서를 만듦
+ *        interleave: 외부전압, B I I B B I I B ..., 외부전압 (ABBA, shunt 측 burst는 짝수로 올림)
+ *        sequential: 외부전압, B..., 외부전압, I...
+ *        외부전압 -> shunt 전환은 외부전압 변환 동안 안정화되고, shunt 양단 사이의 전환에는
+ *        결과를 버리는 짧은 변환(ADC_SEQ_SETTLE)을 한번 넣어 안정화함
+ */
+static void samp_build_seq(void)
+{
+    uint8 i, n = 0;
+    uint8 ext_cnt = adc_filters[READ_EXT].burst;
+    uint8 batt_cnt = adc_filters[READ_BATT_SIDE].burst;
+
+    for (i = 0; i < ext_cnt; i++) {
+        samp_seq[n++] = READ_EXT;
+    }
+
+    if (samp_interleave) {
+        for (i = 0; i < batt_cnt; i += 2) {
+            samp_seq[n++] = READ_BATT_SIDE;
+            samp_seq[n++] = READ_INDUCTOR_SIDE | ADC_SEQ_SETTLE;
+            samp_seq[n++] = READ_INDUCTOR_SIDE;
+            samp_seq[n++] = READ_INDUCTOR_SIDE;
+            samp_seq[n++] = READ_BATT_SIDE | ADC_SEQ_SETTLE;
+            samp_seq[n++] = READ_BATT_SIDE;
+        }
+        for (i = 0; i < ext_cnt; i++) {
+            samp_seq[n++] = READ_EXT;
+        }
+    } else {
+        for (i = 0; i < batt_cnt; i++) {
+            samp_seq[n++] = READ_BATT_SIDE;
+        }
+        for (i = 0; i < ext_cnt; i++) {
+            samp_seq[n++] = READ_EXT;
+        }
+        for (i = 0; i < adc_filters[READ_INDUCTOR_SIDE].burst; i++) {
+            samp_seq[n++] = READ_INDUCTOR_SIDE;
+        }
+    }
+
+    samp_len = n;
+}
+
+/**
+ * @fn samp_convert
+ * @brief 변환 순서의 step번째 변환을 시작
+ *        외부전압 변환 다음이 shunt 측이라면 미리 IO를 전환하여 변환 시간 동안 안정화함
+ */
+static void samp_convert(uint8 step)
+{
+    uint8 entry = samp_seq[step];
+    uint8 opt = entry & ~ADC_SEQ_SETTLE;
+    uint8 ch = (opt == READ_EXT) ? ADC_EXTERNAL : ADC_SHUNT_R;
+
+    if (entry & ADC_SEQ_SETTLE) {
+        //shunt 양단 전환, 결과는 버리므로 짧은 decimation으로 안정화 시간만 확보
+        set_adc_drive((adc_option_t)opt);
+        ADCCON3 = HAL_ADC_REF_125V | ADC_SAMP_DEC_256 | ch;
+        return;
+    }
+
+    if (opt == READ_EXT && step + 1 < samp_len && samp_seq[step + 1] != READ_EXT) {
+        set_adc_drive((adc_option_t)(samp_seq[step + 1] & ~ADC_SEQ_SETTLE));
+    }
+
+    //extra conversion은 ADCCON3 기록시 시작됨
+    ADCCON3 = HAL_ADC_REF_125V | ADC_SAMP_DEC_512 | ch;
+}
+
+/**
+ * @fn samp_diff_push
+ * @brief interleave 측정에서 shunt 측 변환값을 ABBA 차이에 누적, 4개(ABBA 1쌍)가 모이면
+ *        (I1 + I2) - (B1 + B2)를 차동 filter에 넣음
+ */
+static void samp_diff_push(uint8 opt, uint16 adc_val)
+{
+    if (opt == READ_INDUCTOR_SIDE) {
+        samp_diff += (int16)adc_val;
+    } else {
+        samp_diff -= (int16)adc_val;
+    }
+
+    if (++samp_diff_cnt >= 4) {
+        adc_filter_push(&diff_filter, (uint16)(samp_diff + ADC_DIFF_OFFSET));
+        samp_diff = 0;
+        samp_diff_cnt = 0;
+    }
+}
+
+/**
+ * @fn adc_sampler_isr
+ * @brief 변환 완료 인터럽트, 결과를 ring buffer와 filter에 넣고 다음 변환을 시작
+ *        한 주기의 마지막 변환이라면 shunt IO를 끄고 다음 tick까지 대기
+ */
+HAL_ISR_FUNCTION(adc_sampler_isr, ADC_VECTOR)
+{
+    int16 reading;
+    uint8 entry;
+
+    HAL_ENTER_ISR();
+    ADCIF = 0;
+
+    if (samp_step < samp_len) {
+        entry = samp_seq[samp_step];
+
+        if (!(entry & ADC_SEQ_SETTLE)) {
+            //14bit 결과는 상위 14bit에 정렬되어 있음, 음수는 0으로 제한
+            reading = (int16)((uint16)ADCL | ((uint16)ADCH << 8)) >> 2;
+            if (reading < 0) {
+                reading = 0;
+            }
+            adc_ring_push(&adc_rings[entry], (uint16)reading);
+            adc_filter_push(&adc_filters[entry], (uint16)reading);
+
+            if (samp_interleave && entry != READ_EXT) {
+                samp_diff_push(entry, (uint16)reading);
+            }
+        }
+
+        if (++samp_step < samp_len) {
+            samp_convert(samp_step);
+        } else {
+            close_adc_driver();
+            samp_step = ADC_SEQ_IDLE;
+        }
+    }
+
+    HAL_EXIT_ISR();
+}
+
+/**
+ * @fn read_diff_blocking
+ * @brief sampler 없이 ABBA 순서로 4^os_bits쌍을 직접 변환하여 차동 filter 출력 형식으로 반환
+ *        IO 전환마다 open_adc_driver에서 한번씩 안정화 대기
+ */
+static uint32 read_diff_blocking(void)
+{
+    adc_filter_t filt;
+    uint16 i, cnt;
+    int16 diff;
+
+    filt.os_bits = diff_filter.os_bits;
+    filt.iir_shift = 0;
+    adc_filter_prime(&filt, 0);
+    cnt = (uint16)1 << (filt.os_bits << 1);
+
+    open_adc_driver(READ_BATT_SIDE);
+    for (i = 0; i < cnt; i++) {
+        diff = -(int16)read_adc(READ_BATT_SIDE);
+        open_adc_driver(READ_INDUCTOR_SIDE);
+        diff += (int16)read_adc(READ_INDUCTOR_SIDE);
+        diff += (int16)read_adc(READ_INDUCTOR_SIDE);
+        open_adc_driver(READ_BATT_SIDE);
+        diff -= (int16)read_adc(READ_BATT_SIDE);
+        adc_filter_push(&filt, (uint16)(diff + ADC_DIFF_OFFSET));
+    }
+    close_adc_driver();
+
+    return filt.out;
+}
+
+/**
+ * @fn read_diff_hr
+ * @brief 차동 filter 출력, ((I1 + I2) - (B1 + B2) + ADC_DIFF_OFFSET) << ADC_HR_SHIFT
+ */
+static uint32 read_diff_hr(void)
+{
+    halIntState_t is;
+    uint32 hr_val;
+
+    if (!samp_active) {
+        return read_diff_blocking();
+    }
+
+    HAL_ENTER_CRITICAL_SECTION(is);
+    hr_val = diff_filter.out;
+    HAL_EXIT_CRITICAL_SECTION(is);
+
+    return hr_val;
+}
+
+/**
+ * @fn adc_sampler_start
+ * @brief background sampler 시작, 각 channel을 직접 읽어 ring buffer와 filter를 채운 후
+ *        ADC 인터럽트를 켬. 이후 ADC_SAMPLE_PERIOD마다 adc_sampler_tick을 호출해야 함.
+ */
+void adc_sampler_start(void)
+{
+    uint8 i;
+    uint32 hr_val;
+
+    if (samp_active) {
+        return;
+    }
+
+    for (i = 0; i < ADC_RING_CNT; i++) {
+        hr_val = read_adc_hr((adc_option_t)i);
+        adc_ring_fill(&adc_rings[i], (uint16)((hr_val + (1 << (ADC_HR_SHIFT - 1))) >> ADC_HR_SHIFT));
+        adc_filter_prime(&adc_filters[i], hr_val);
+    }
+    adc_filter_prime(&diff_filter, read_diff_blocking());
+    samp_build_seq();
+
+    //판정기는 debounce 없이 현재 전압으로 시작
+    st_ext_class.cls = ext_voltage_analysis(read_voltage(READ_EXT));
+    st_ext_class.cand = st_ext_class.cls;
+    st_ext_class.debounce = 0;
+    st_ext_class.ticks = 0;
+
+    //측정 pin을 아날로그 입력으로 고정, HalAdcRead처럼 변환마다 바꾸지 않음
+    APCFG |= BV(ADC_EXTERNAL) | BV(ADC_SHUNT_R);
+
+    samp_step = ADC_SEQ_IDLE;
+    ADCIF = 0;
+    ADCIE = 1;
+    samp_active = TRUE;
+}
+
+/**
+ * @fn adc_sampler_stop
+ * @brief background sampler 중지, 진행중인 변환은 결과를 버림
+ */
+void adc_sampler_stop(void)
+{
+    halIntState_t is;
+
+    HAL_ENTER_CRITICAL_SECTION(is);
+    ADCIE = 0;
+    ADCIF = 0;
+    samp_step = ADC_SEQ_IDLE;
+    samp_active = FALSE;
+    HAL_EXIT_CRITICAL_SECTION(is);
+
+    APCFG &= ~(BV(ADC_EXTERNAL) | BV(ADC_SHUNT_R));
+    close_adc_driver();
+}
+
+/**
+ * @fn adc_sampler_tick
+ * @brief 한 주기의 변환을 시작하고 바로 반환, 이전 주기가 끝나지 않았다면 건너뜀
+ */
+void adc_sampler_tick(void)
+{
+    if (!samp_active || samp_step != ADC_SEQ_IDLE) {
+        return;
+    }
+
+    samp_diff = 0;
+    samp_diff_cnt = 0;
+    samp_step = 0;
+    samp_convert(0);
+}
+
+uint8 adc_sampler_active(void)
+{
+    return samp_active;
+}
+
+/**
+ * @fn samp_reconfig
+ * @brief 진행중인 주기를 버리고 변환 순서를 다시 만듦, critical section 안에서 호출
+ */
+static void samp_reconfig(void)
+{
+    if (samp_step != ADC_SEQ_IDLE) {
+        samp_step = ADC_SEQ_IDLE;
+        close_adc_driver();
+    }
+    samp_build_seq();
+}
+
+/**
+ * @fn adc_curr_mode
+ * @brief 전류 측정 방식 선택
+ *        ADC_CURR_INTERLEAVE: 배터리측/인덕터측을 ABBA 순서로 번갈아 변환, 차동 filter 사용
+ *        ADC_CURR_SEQUENTIAL: 한쪽씩 burst 변환, 두 channel filter 출력의 차이 사용
+ */
+void adc_curr_mode(uint8 mode)
+{
+    halIntState_t is;
+
+    HAL_ENTER_CRITICAL_SECTION(is);
+    if (!samp_interleave && mode == ADC_CURR_INTERLEAVE) {
+        //sequential 동안 갱신되지 않은 차동 filter를 두 channel filter 출력의 차이로 초기화
+        adc_filter_prime(&diff_filter, ((uint32)ADC_DIFF_OFFSET << ADC_HR_SHIFT)
+                         + (adc_filters[READ_INDUCTOR_SIDE].out << 1)
+                         - (adc_filters[READ_BATT_SIDE].out << 1));
+    }
+    samp_interleave = (mode == ADC_CURR_INTERLEAVE);
+    samp_reconfig();
+    HAL_EXIT_CRITICAL_SECTION(is);
+}
+
+/**
+ * @fn adc_filter_config
+ * @brief channel의 oversampling filter 설정을 바꿈, filter는 현재 출력으로 다시 초기화됨
+ *        출력 1개당 4^os_bits회 변환, tick당 burst회 변환하므로 출력 주기는
+ *        ADC_SAMPLE_PERIOD * 4^os_bits / burst [ms]
+ *        READ_CURR_CHG/READ_CURR_DISCHG는 차동 filter를 설정하며 burst는 무시됨
+ *        (interleave 방식에서 차동 filter 입력은 tick당 배터리측 burst / 2쌍)
+ *
+ * @param os_bits 증가시킬 bit 수(0 ~ ADC_OS_MAX)
+ * @param iir_shift IIR 계수 1/2^iir_shift, 0이면 사용 안함(0 ~ ADC_IIR_MAX)
+ * @param burst tick당 변환 횟수(1 ~ ADC_BURST_MAX)
+ * @return 0: 성공, 1: 잘못된 설정
+ */
+uint8 adc_filter_config(adc_option_t adc_opt, uint8 os_bits, uint8 iir_shift, uint8 burst)
+{
+    halIntState_t is;
+    adc_filter_t *p_filt;
+
+    if (adc_opt > READ_CURR_CHG || os_bits > ADC_OS_MAX || iir_shift > ADC_IIR_MAX
+        || burst == 0 || burst > ADC_BURST_MAX) {
+        return 1;
+    }
+    p_filt = (adc_opt < ADC_RING_CNT) ? &adc_filters[adc_opt] : &diff_filter;
+
+    //진행중인 주기의 변환 순서가 바뀌지 않도록 ISR과 분리
+    HAL_ENTER_CRITICAL_SECTION(is);
+    p_filt->os_bits = os_bits;
+    p_filt->iir_shift = iir_shift;
+    p_filt->burst = burst;
+    adc_filter_prime(p_filt, p_filt->out);
+    samp_reconfig();
+    HAL_EXIT_CRITICAL_SECTION(is);
+
+    return 0;
+}
+
+/**
+ * @fn adc_sampler_read
+ * @brief ring buffer에서 channel의 최신값을 읽음
+ */
+static uint16 adc_sampler_read(adc_option_t adc_opt)
+{
+    halIntState_t is;
+    adc_ring_t *p_ring = &adc_rings[adc_opt];
+    uint16 adc_val;
+
+    HAL_ENTER_CRITICAL_SECTION(is);
+    adc_val = p_ring->buf[(p_ring->idx - 1) & (ADC_RING_SIZE - 1)];
+    HAL_EXIT_CRITICAL_SECTION(is);
+
+    return adc_val;
+}
+
+/**
+ * @fn read_adc_hr
+ * @brief channel의 oversampling filter 출력, ADC_HR_SHIFT bit의 소수부를 가짐
+ *        sampler가 동작하지 않으면 4^os_bits회 직접 변환하여 decimation만 적용
+ *
+ * @return adc << ADC_HR_SHIFT
+ */
+uint32 read_adc_hr(adc_option_t adc_opt)
+{
+    halIntState_t is;
+    uint32 hr_val;
+    uint16 i, cnt;
+    uint8 os_bits;
+
+    if (adc_opt >= ADC_RING_CNT) {
+        return 0;
+    }
+
+    if (samp_active) {
+        HAL_ENTER_CRITICAL_SECTION(is);
+        hr_val = adc_filters[adc_opt].out;
+        HAL_EXIT_CRITICAL_SECTION(is);
+        return hr_val;
+    }
+
+    os_bits = adc_filters[adc_opt].os_bits;
+    cnt = (uint16)1 << (os_bits << 1);
+    hr_val = 0;
+
+    open_adc_driver(adc_opt);
+    for (i = 0; i < cnt; i++) {
+        hr_val += read_adc(adc_opt);
+    }
+    close_adc_driver();
+
+    return adc_decimate(hr_val, os_bits);
+}
+
 uint16 read_adc(adc_option_t adc_opt) 
 {
     uint16 adc_val;
 
+    if (samp_active && adc_opt < ADC_RING_CNT) {
+        //sampler 동작중에는 변환이 겹치지 않도록 가장 최근 변환값을 사용
+        return adc_sampler_read(adc_opt);
+    }
+
     switch(adc_opt) {
         case READ_BATT_SIDE:
         case READ_INDUCTOR_SIDE:
@@ -74,11 +705,21 @@ uint16 read_adc(adc_option_t adc_opt)
     return adc_val;
 }
 
+/**
+ * @fn read_adc_sampling
+ * @brief samp_cnt번 읽은 adc 평균값
+ *        background sampler 동작중에는 oversampling filter 출력을 반올림하여 바로 반환
+ */
 uint16 read_adc_sampling(uint8 samp_cnt, adc_option_t adc_opt)
 {
     uint8 i;
     uint32 adc_tmp = 0;
 
+    if (samp_active && adc_opt < ADC_RING_CNT) {
+        adc_tmp = read_adc_hr(adc_opt) + (1 << (ADC_HR_SHIFT - 1));
+        return (uint16)(adc_tmp >> ADC_HR_SHIFT);
+    }
+
     open_adc_driver(adc_opt);
 
     for(i = 0; i < samp_cnt; i++) {
@@ -91,25 +732,40 @@ uint16 read_adc_sampling(uint8 samp_cnt, adc_option_t adc_opt)
     return (uint16)adc_tmp;
 }
 
-float read_voltage(adc_option_t adc_opt)
+/**
+ * @fn read_voltage
+ * @brief adc를 한번 읽어 전압으로 변환
+ * 
+ * @return 전압[mV]
+ */
+uint16 read_voltage(adc_option_t adc_opt)
 {
-    float f_voltage = 0;
+    uint16 voltage;
     uint16 adc_org;
 
+    if (samp_active) {
+        //sampler 동작중에는 IO 전환 및 대기 없이 filter 출력 사용
+        return convert_voltage(read_adc_sampling(1, adc_opt), adc_opt);
+    }
+
     open_adc_driver(adc_opt); 
     
     adc_org = read_adc(adc_opt);
-    f_voltage = convert_voltage(adc_org, adc_opt);
+    voltage = convert_voltage(adc_org, adc_opt);
 
     close_adc_driver();
 
-    return f_voltage;
+    return voltage;
 }
 
 uint16 read_voltage_uint16(adc_option_t adc_opt)
 {
     uint16 adc_org;
 
+    if (samp_active) {
+        return read_adc(adc_opt);
+    }
+
     open_adc_driver(adc_opt); 
     
     adc_org = read_adc(adc_opt);
@@ -119,35 +775,123 @@ uint16 read_voltage_uint16(adc_option_t adc_opt)
     return adc_org;
 }
 
-float read_voltage_sampling(uint8 samp_cnt, adc_option_t adc_opt)
+/**
+ * @fn read_voltage_sampling
+ * @brief adc를 samp_cnt번 읽은 평균을 전압으로 변환
+ * 
+ * @return 전압[mV]
+ */
+uint16 read_voltage_sampling(uint8 samp_cnt, adc_option_t adc_opt)
 {
-    float f_voltage;
     uint16 adc_samp;
 
     adc_samp = read_adc_sampling(samp_cnt, adc_opt);
-    f_voltage = convert_voltage(adc_samp, adc_opt);
 
-    return f_voltage;
+    return convert_voltage(adc_samp, adc_opt);
 }
 
-uint8 ext_voltage_analysis(float voltage)
+/**
+ * @fn ext_voltage_analysis
+ * @brief 외부 전압[mV]으로 충전/통신/무전압 상태를 판정
+ * 
+ * @return EXT_MIN_V || EXT_COMM_V || EXT_ZERO_V
+ */
+uint8 ext_voltage_analysis(uint16 voltage)
 {
-    if (voltage >= EXT_MIN_V) {
+    if (voltage >= EXT_MIN_MV) {
         return EXT_MIN_V;
-    } else if (voltage >= EXT_COMM_V) {
+    } else if (voltage >= EXT_COMM_MV) {
         return EXT_COMM_V;
     }
 
     return EXT_ZERO_V;
 }
 
-uint16 read_current(adc_option_t curr_direction) 
+/**
+ * @fn ext_class_analysis
+ * @brief 현재 판정에 따라 해제 기준을 낮춘 hysteresis 판정
+ */
+static uint8 ext_class_analysis(uint16 voltage, uint8 cur_cls)
 {
-    float res_curr = 0;
-    uint16 adc_values[2];
+    uint16 min_mv = EXT_MIN_MV;
+    uint16 comm_mv = EXT_COMM_MV;
 
-    adc_values[0] = read_adc_sampling(2, READ_BATT_SIDE);
-    adc_values[1] = read_adc_sampling(2, READ_INDUCTOR_SIDE);
+    if (cur_cls == EXT_MIN_V) {
+        min_mv -= EXT_MIN_HYST_MV;
+    }
+    if (cur_cls != EXT_ZERO_V) {
+        comm_mv -= EXT_COMM_HYST_MV;
+    }
+
+    if (voltage >= min_mv) {
+        return EXT_MIN_V;
+    } else if (voltage >= comm_mv) {
+        return EXT_COMM_V;
+    }
+
+    return EXT_ZERO_V;
+}
+
+/**
+ * @fn ext_class_update
+ * @brief 외부전압 filter 출력으로 판정을 갱신, sampler tick마다 호출
+ *        다른 판정이 EXT_DEBOUNCE_CNT회 연속되어야 변경하며 변경시 유지 횟수를 0부터 다시 셈
+ */
+void ext_class_update(void)
+{
+    uint8 cls = ext_class_analysis(read_voltage(READ_EXT), st_ext_class.cls);
+
+    if (cls == st_ext_class.cls) {
+        st_ext_class.debounce = 0;
+    } else if (cls != st_ext_class.cand) {
+        st_ext_class.cand = cls;
+        st_ext_class.debounce = 1;
+    } else {
+        st_ext_class.debounce++;
+    }
+
+    if (st_ext_class.debounce >= EXT_DEBOUNCE_CNT) {
+        st_ext_class.cls = cls;
+        st_ext_class.debounce = 0;
+        st_ext_class.ticks = 0;
+    } else if (st_ext_class.ticks < 0xFFFF) {
+        st_ext_class.ticks++;
+    }
+}
+
+/**
+ * @fn ext_voltage_time
+ * @brief 현재 외부전압 판정이 유지된 시간
+ * 
+ * @return ext_class_update 호출(sampler tick) 횟수, 최대 0xFFFF
+ */
+uint16 ext_voltage_time(void)
+{
+    return st_ext_class.ticks;
+}
+
+/**
+ * @fn read_current
+ * @brief shunt 저항 양단의 adc 차이로 충/방전 전류를 계산
+ *        interleave 방식은 차동 filter 출력(ABBA 1쌍, 2배 크기)을,
+ *        sequential 방식은 두 channel filter 출력(1/2^ADC_HR_SHIFT LSB)의 차이를 사용
+ * 
+ * @return 전류[mA], 해당 방향으로 흐르지 않으면 0
+ */
+uint16 read_current(adc_option_t curr_direction) 
+{
+    uint32 res_curr = 0;
+    uint32 adc_values[2];
+    uint8 shift = CURR_Q_SHIFT + ADC_HR_SHIFT;
+
+    if (samp_interleave) {
+        adc_values[0] = (uint32)ADC_DIFF_OFFSET << ADC_HR_SHIFT;
+        adc_values[1] = read_diff_hr();
+        shift++;
+    } else {
+        adc_values[0] = read_adc_hr(READ_BATT_SIDE);
+        adc_values[1] = read_adc_hr(READ_INDUCTOR_SIDE);
+    }
 
     switch (curr_direction) {
         case READ_CURR_CHG: 
@@ -165,34 +909,60 @@ uint16 read_current(adc_option_t curr_direction)
             break;
     }
 
-    res_curr = ((res_curr * REF125_UNIT * BATT_RATIO_V) / SHUNT_R_VAL) * 1000;
+    //interleave 차이는 1bit 더 크므로 곱셈이 넘칠때는 그 bit를 먼저 버림
+    if (res_curr > CURR_HR_MAX && shift > CURR_Q_SHIFT + ADC_HR_SHIFT) {
+        res_curr = (res_curr + 1) >> 1;
+        shift--;
+    }
+
+    //그래도 CURR_HR_MAX를 넘으면 곱셈이 uint32를 넘음, 이미 0xFFFF mA 이상
+    if (res_curr > CURR_HR_MAX) {
+        return 0xFFFF;
+    }
+
+    res_curr = (res_curr * CURR_MA_Q + ((uint32)1 << (shift - 1))) >> shift;
+    if (res_curr > 0xFFFF) {
+        return 0xFFFF;
+    }
 
     return (uint16)res_curr;
 }
 
 /* local function group */
 
-static float convert_voltage(uint16 adc_org, adc_option_t adc_opt) 
+static uint16 convert_voltage(uint16 adc_org, adc_option_t adc_opt) 
 {
-    float f_voltage;
+    uint32 q;
+
     switch (adc_opt) {
         case READ_BATT_SIDE:
         case READ_INDUCTOR_SIDE:
-            if (g_calib == 0) {
-                f_voltage = adc_org * REF125_UNIT * BATT_RATIO_V;
-            } else {
-                f_voltage = adc_org * REF125_UNIT * BATT_RATIO_V * g_calib;
-            }
+            //배터리 측은 보정값이 반영된 변환 상수 사용
+            q = st_calib.batt_q;
             break;
         case READ_EXT:
-            f_voltage = adc_org * REF125_UNIT * EXT_RATIO_V;
+            q = EXT_MV_Q;
             break;
+        default:
+            return 0;
     }
-    return f_voltage;
+
+    if (adc_org > ADC_FULL_SCALE) {
+        //14bit 음수 결과는 최대값으로 제한하여 곱셈 overflow 방지
+        adc_org = ADC_FULL_SCALE;
+    }
+
+    return (uint16)(((uint32)adc_org * q + ADC_Q_ROUND) >> ADC_Q_SHIFT);
 }
 
+/**
+ * @fn ext_voltage_result
+ * @brief ext_class_update가 확정한 외부전압 판정, ADC 변환 없음
+ * 
+ * @return EXT_MIN_V || EXT_COMM_V || EXT_ZERO_V
+ */
 uint8 ext_voltage_result(void)
 {
-	return ext_voltage_analysis(read_voltage(READ_EXT));
+	return st_ext_class.cls;
 }
 
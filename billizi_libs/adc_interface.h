@@ -30,25 +30,31 @@ CHRGED_VOLT : 충전되는 전압
 #define ADC_SHUNT_R     HAL_ADC_CHANNEL_6
 
 /* ADC resolution calculate unit */
-#define REF125_UNIT (1.25/8191)
-#define REFVDD_UNIT (3.3/8191)  
-//current sensor shunt resistor value(0.1ohm Parallel)
-#define SHUNT_R_VAL (0.025)     
+#define ADC_FULL_SCALE  8191    //14bit 분해능의 최대값
+#define REF125_MV       1250    //내부 기준전압 1.25V
+//current sensor shunt resistor value(0.1ohm Parallel), [mOhm]
+#define SHUNT_R_MOHM    25
 
 /* ADC distribution resistance value */
 #define EXT_RATIO_V  ((1000+43)/(43))
 #define BATT_RATIO_V  4     //(30+10)/10 = 4
 #define SAMPLING_CNT  5
 
-/* BATT Device reference voltage */
-#define EXT_MIN_V   20 // 외부 충전 전압으로 인정할  최소값
-#define EXT_COMM_V  8  // 통신 상태로 인정할 전압값
+/* ext_voltage_analysis 판정 결과 */
+#define EXT_MIN_V   20 // 외부 충전 전압
+#define EXT_COMM_V  8  // 통신 전압
 #define EXT_ZERO_V  0  //  외부 전압 없음
-#define MIN_BATT_V  (3.1)
-#define MAX_BATT_V  (4.2)
-#define SERVICE_BATT_V   (3.2)
-#define BATT_REF_V  (3.75)
+
+/* BATT Device reference voltage [mV] */
+#define EXT_MIN_MV  20000   // 외부 충전 전압으로 인정할  최소값
+#define EXT_COMM_MV 8000    // 통신 상태로 인정할 전압값
+#define MIN_BATT_MV 3100
+#define MAX_BATT_MV 4200
+#define SERVICE_BATT_MV  3200
+#define BATT_REF_MV 3750
 #define BATT_CAPACITY   17760   //3.7[V] * 4800[mA] = 17760[mWh]
+#define BATT_NOMINAL_MV 3700
+#define BATT_CAPACITY_MAH   ((uint16)((uint32)BATT_CAPACITY * 1000 / BATT_NOMINAL_MV))  //4800[mAh]
 /*
 READ_EXT 전압:ADC값
 17.945V : 4900
@@ -60,6 +66,45 @@ READ_BATT_SIDE
 3.743v : 6403 
 3.905v : 6678
 */
+/* 고정소수점 변환
+ * mV = (adc * Q상수 + ADC_Q_ROUND) >> ADC_Q_SHIFT, 전류는 CURR_Q_SHIFT 사용
+ * Q상수는 기준전압과 분압비(보정값)로부터 컴파일 시점에 계산되어 변환시에는 곱셈과 shift만 수행함. */
+#define ADC_Q_SHIFT     16
+#define ADC_Q_ROUND     ((uint32)1 << (ADC_Q_SHIFT - 1))
+#define BATT_MV_Q   (((((uint32)REF125_MV * BATT_RATIO_V) << ADC_Q_SHIFT) + (ADC_FULL_SCALE >> 1)) / ADC_FULL_SCALE)
+#define EXT_MV_Q    (((((uint32)REF125_MV * EXT_RATIO_V) << ADC_Q_SHIFT) + (ADC_FULL_SCALE >> 1)) / ADC_FULL_SCALE)
+
+#define CURR_Q_SHIFT    12
+#define CURR_MA_Q   (((((uint32)REF125_MV * BATT_RATIO_V * 1000 / SHUNT_R_MOHM) << CURR_Q_SHIFT) + \
+                      (ADC_FULL_SCALE >> 1)) / ADC_FULL_SCALE)
+//read_current에서 곱셈과 반올림(interleave는 1 << 16)이 넘치지 않는 최대 adc 차이(1/16 LSB)
+#define CURR_HR_MAX ((0xFFFFFFFFUL - ((uint32)1 << (CURR_Q_SHIFT + ADC_HR_SHIFT))) / CURR_MA_Q)
+
+/* calibration manager
+ * 보정 adc 값(calibration word)과 보정이 반영된 배터리 전압 변환 상수(batt_q)를 RAM에 유지함.
+ * self-calibration 값은 설정 저장소에 바로 기록(write-through)되고,
+ * 최근 만충 측정값 이력의 중앙값과 CALIB_OUTLIER_ADC 이상 차이나는 값은 반영하지 않음. */
+#define CALIB_NONE      0
+#define CALIB_REF       1
+#define CALIB_SELF      2
+
+//보정값(adc)으로 나누면 batt_q가 되는 상수, 보정값이 기준전압(mV)이 되도록 함
+#define CALIB_SELF_NUM  ((uint32)MAX_BATT_MV << ADC_Q_SHIFT)
+#define CALIB_REF_NUM   ((uint32)BATT_REF_MV << ADC_Q_SHIFT)
+
+#define CALIB_HIST_CNT      4
+#define CALIB_OUTLIER_ADC   100     //약 60mV, 만충 전압의 1.5%
+
+typedef struct _CALIB_MGR {
+    uint8 mode;         //CALIB_NONE, CALIB_REF, CALIB_SELF
+    uint16 calib_adc;   //현재 보정 adc 값
+    uint32 batt_q;      //보정이 반영된 배터리 adc->mV 변환 상수
+    uint16 hist[CALIB_HIST_CNT];    //최근 반영된 self-calibration 값
+    uint8 hist_cnt;
+    uint8 hist_idx;
+    uint16 reject_adc;  //직전에 outlier로 판정된 값, 0: 없음
+}calib_mgr_t;
+
 typedef enum _ADC_OPT {
     READ_BATT_SIDE,   //after shunt resistor, battery side
     READ_INDUCTOR_SIDE,   //before shunt resistor, inductor side
@@ -68,18 +113,110 @@ typedef enum _ADC_OPT {
     READ_CURR_CHG
 }adc_option_t;
 
+/* background sampler
+ * ADC_SAMPLE_PERIOD마다 adc_sampler_tick이 외부전압/배터리측/인덕터측 변환을 시작하고
+ * 이후 변환은 ADC 인터럽트에서 이어서 진행, 결과는 channel별 ring buffer와 filter에 저장됨.
+ * 외부전압 -> shunt 전환의 안정화(50us)는 외부전압 변환시간(약 132us) 동안 이루어지고,
+ * shunt 양단 사이의 전환은 결과를 버리는 decimation 256 변환(약 68us)으로 안정화함.
+ * 동작중에는 read_adc가 최신 변환값을, read_adc_sampling이 filter 출력을 O(1)로 반환함.
+ *
+ * 전류 측정은 기본으로 배터리측/인덕터측을 한쪽씩 burst 변환(sequential)함.
+ * adc_curr_mode로 B I I B 순서의 interleave를 선택할 수 있으며, 양쪽 변환 시각의 중심이 같아
+ * 큰 공통 전압 ripple은 상쇄되지만 ripple이 작으면 잡음이 더 크고 tick당 변환이 14회(sequential 10회)임. */
+#define ADC_SAMPLE_PERIOD   10      //최소 변환 주기(ms), 실제 주기는 호출하는 쪽에서 결정
+#define ADC_RING_SHIFT      3
+#define ADC_RING_SIZE       (1 << ADC_RING_SHIFT)
+#define ADC_RING_CNT        (READ_EXT + 1)          //READ_BATT_SIDE, READ_INDUCTOR_SIDE, READ_EXT
+#define ADC_SEQ_MAX         (ADC_BURST_MAX * 5)     //외부전압 2회 + ABBA(변환 4, 안정화 2) burst/2회
+#define ADC_SEQ_IDLE        0xFF
+#define ADC_SEQ_SETTLE      0x80                    //변환 순서 flag, IO 전환 후 결과를 버리는 변환
+
+//ADCCON3 extra conversion 설정, HAL_ADC_RESOLUTION_14와 같은 decimation
+#define ADC_SAMP_DEC_512    0x30
+#define ADC_SAMP_DEC_256    0x20                    //안정화용, 약 68us
+
+//전류 측정 방식, adc_curr_mode
+#define ADC_CURR_SEQUENTIAL 0
+#define ADC_CURR_INTERLEAVE 1
+
+typedef struct _ADC_RING {
+    uint16 buf[ADC_RING_SIZE];
+    uint8 idx;          //다음에 기록할 위치
+}adc_ring_t;
+
+/* oversample & decimate filter
+ * 4^os_bits개 변환을 합산(box filter)하여 os_bits bit를 얻고(합계는 2 * os_bits bit 증가),
+ * 선택적으로 1차 IIR(계수 1/2^iir_shift)을 거침. 출력은 항상 ADC_HR_SHIFT bit 소수부를 가짐.
+ * 백색잡음 기준 os_bits 1bit당 잡음 1/2, IIR은 추가로 약 1/sqrt(2^(iir_shift+1) - 1).
+ * 출력 갱신 주기는 4^os_bits / burst tick, burst는 tick마다 같은 channel을 연속 변환하는 횟수. */
+#define ADC_HR_SHIFT        4                       //filter 출력 소수부 bit 수
+#define ADC_OS_MAX          ADC_HR_SHIFT            //4^4 * 8191 < 2^22
+#define ADC_IIR_MAX         8                       //2^8 * (8191 << 4) < 2^26
+#define ADC_BURST_MAX       8
+
+//배터리측/인덕터측: tick당 4회 변환, 16회마다 2bit 증가, IIR 1/4 (출력 40ms, 시정수 약 160ms)
+#define ADC_SHUNT_OS_BITS   2
+#define ADC_SHUNT_IIR_SHIFT 2
+#define ADC_SHUNT_BURST     4
+//외부전압: 변환 순서에 두번 있으므로 tick당 2회 변환, 연결 감지가 늦어지지 않도록 1bit 증가만
+#define ADC_EXT_OS_BITS     1
+#define ADC_EXT_IIR_SHIFT   0
+#define ADC_EXT_BURST       1
+//interleave 차동 filter: tick당 ABBA 2쌍, 4쌍마다 1bit 증가, IIR 1/4 (출력 20ms, 시정수 약 80ms)
+#define ADC_DIFF_OS_BITS    1
+#define ADC_DIFF_IIR_SHIFT  2
+#define ADC_DIFF_OFFSET     ((int16)ADC_FULL_SCALE << 1)   //ABBA 차이(+-2 * 8191)를 unsigned로
+
+/* 외부전압 판정기
+ * sampler tick마다 ext_class_update가 외부전압 filter 출력을 판정하여 결과를 저장함.
+ * 현재 판정을 벗어나는 기준은 진입 기준보다 EXT_*_HYST_MV만큼 낮고(schmitt trigger),
+ * 새 판정은 EXT_DEBOUNCE_CNT회 연속일때 확정됨. 사용하는 쪽은 ext_voltage_result로 값만 읽음. */
+#define EXT_MIN_HYST_MV     1500    //충전 전압 판정 해제: 18.5V 미만
+#define EXT_COMM_HYST_MV    1000    //통신 전압 판정 해제: 7V 미만
+#define EXT_DEBOUNCE_CNT    3       //판정 변경에 필요한 연속 tick 수
+
+typedef struct _EXT_CLASS {
+    uint8 cls;          //확정된 판정, EXT_MIN_V || EXT_COMM_V || EXT_ZERO_V
+    uint8 cand;         //변경 후보 판정
+    uint8 debounce;     //후보 판정 연속 횟수
+    uint16 ticks;       //현재 판정 유지 횟수, 0xFFFF에서 멈춤
+}ext_class_t;
+
+typedef struct _ADC_FILTER {
+    uint8 os_bits;      //decimation 단계의 증가 bit 수, 4^os_bits개 합산
+    uint8 iir_shift;    //0이면 IIR 사용 안함
+    uint8 burst;        //tick당 변환 횟수
+    uint16 cnt;         //acc에 합산된 변환 수
+    uint32 acc;         //box filter 합계
+    uint32 iir;         //IIR 상태, 출력 << iir_shift
+    uint32 out;         //filter 출력, adc << ADC_HR_SHIFT
+}adc_filter_t;
+
 void get_gparam_calib(void *p_value);
 void setup_calib_value(uint8 self_calib, uint16 adc_ref);
+uint8 calib_load(void);
+uint8 calib_update_self(uint16 adc_value);
+uint16 calib_get_adc(void);
 
 void adc_init();
 uint16 read_adc(adc_option_t adc_opt);
 uint16 read_adc_sampling(uint8 samp_cnt, adc_option_t adc_opt);
-float read_voltage(adc_option_t adc_opt);
+uint16 read_voltage(adc_option_t adc_opt);
 uint16 read_voltage_uint16(adc_option_t adc_opt);
-float read_voltage_sampling(uint8 samp_cnt, adc_option_t adc_opt);
+uint16 read_voltage_sampling(uint8 samp_cnt, adc_option_t adc_opt);
 uint16 read_current(adc_option_t curr_direction);
-
-uint8 ext_voltage_analysis(float voltage);
+uint32 read_adc_hr(adc_option_t adc_opt);
+
+uint8 ext_voltage_analysis(uint16 voltage);
+void ext_class_update(void);
+uint16 ext_voltage_time(void);
+
+void adc_sampler_start(void);
+void adc_sampler_stop(void);
+void adc_sampler_tick(void);
+uint8 adc_sampler_active(void);
+void adc_curr_mode(uint8 mode);
+uint8 adc_filter_config(adc_option_t adc_opt, uint8 os_bits, uint8 iir_shift, uint8 burst);
 
 void open_adc_driver(adc_option_t adc_opt);
 void close_adc_driver();
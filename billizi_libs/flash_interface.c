@@ -1,10 +1,21 @@
 #include "flash_interface.h"
 
+static flash_stats_t st_flash_stats;
+
+//settings store RAM index, key별 최신값과 유효여부(bit)
+static uint16 setting_vals[SET_KEY_CNT];
+static uint8 setting_valid = 0;
+
+//현재 사용중인 설정 페이지 주소(0: 없음), 페이지 sequence, 다음 기록 위치
+static uint16 setting_addr = 0;
+static uint16 setting_seq = 0;
+static uint16 setting_wr_addr = 0;
+
 void read_flash(uint16 ai_addr, eFlash_Var_t value_type, void *p_value)
 {
-    uint8 tmp[4];
+    uint8 tmp[HAL_FLASH_WORD_SIZE];
 
-    HalFlashRead(ADDR_2_PAGE(ai_addr), ADDR_2_RECORD(ai_addr) * 4, tmp, HAL_FLASH_WORD_SIZE);
+    read_flash_bulk(ai_addr, tmp, 1);
     switch(value_type) {
         case FLOPT_UINT8:
             *((uint8*)p_value) = *(uint8*)tmp;
@@ -21,31 +32,106 @@ void read_flash(uint16 ai_addr, eFlash_Var_t value_type, void *p_value)
     }
 }
 
+/**
+ * @fn read_flash_bulk
+ * @brief 연속된 word 영역을 읽음, 플래시 bank를 XDATA 영역에 한번 매핑하여 한번에 복사
+ *        HalFlashRead를 word마다 호출할때 반복되는 매핑/해제 과정을 줄임.
+ *        bank(HAL_FLASH_PAGE_PER_BANK 페이지) 경계를 넘는 경우 bank별로 나누어 매핑함.
+ * 
+ * @param ai_addr: 읽을 시작 주소(word 단위)
+ * @param p_buf: 읽은 값을 저장할 버퍼, word_cnt * 4byte 이상
+ * @param word_cnt: 읽을 word 개수
+ */
+void read_flash_bulk(uint16 ai_addr, void *p_buf, uint16 word_cnt)
+{
+    halIntState_t is;
+    uint8 memctr;
+    uint8 pg;
+    uint16 offset, cnt;
+    uint8 *p_dst = (uint8 *)p_buf;
+
+    st_flash_stats.read_calls++;
+    st_flash_stats.read_words += word_cnt;
+
+    while (word_cnt) {
+        pg = ADDR_2_PAGE(ai_addr);
+
+        //bank 내에서의 byte offset, bank 끝을 넘지 않도록 이번에 읽을 word 수 제한
+        offset = ((pg % HAL_FLASH_PAGE_PER_BANK) * HAL_FLASH_PAGE_SIZE) +
+                 (ADDR_2_RECORD(ai_addr) * HAL_FLASH_WORD_SIZE);
+        cnt = (FLASH_BANK_SIZE - offset) / HAL_FLASH_WORD_SIZE;
+        if (cnt > word_cnt) {
+            cnt = word_cnt;
+        }
+
+        HAL_ENTER_CRITICAL_SECTION(is);
+        memctr = MEMCTR;
+        MEMCTR = (MEMCTR & 0xF8) | (pg / HAL_FLASH_PAGE_PER_BANK);
+        osal_memcpy(p_dst, (uint8 *)(HAL_FLASH_PAGE_MAP + offset), cnt * HAL_FLASH_WORD_SIZE);
+        MEMCTR = memctr;
+        HAL_EXIT_CRITICAL_SECTION(is);
+
+        ai_addr += cnt;
+        p_dst += cnt * HAL_FLASH_WORD_SIZE;
+        word_cnt -= cnt;
+    }
+}
+
 uint8 write_flash(uint16 ai_addr, void *p_value)
 {
-    uint8 *tmp_value;
-    uint32 validation;
+    return write_flash_burst(ai_addr, (uint32 *)p_value, 1);
+}
+
+/**
+ * @fn write_flash_burst
+ * @brief 연속된 여러 word를 한번의 HalFlashWrite(DMA)로 기록하고
+ *        기록된 영역 전체를 한번에 읽어 검증
+ * 
+ * @param ai_addr: 기록할 시작 주소, 기록 범위는 한 페이지를 넘을 수 없음
+ * @param p_words: 기록할 word 배열
+ * @param word_cnt: 기록할 word 개수 (최대 FLASH_BURST_MAX)
+ * 
+ * @return error=1||success=0
+ */
+uint8 write_flash_burst(uint16 ai_addr, uint32 *p_words, uint8 word_cnt)
+{
+    uint32 validation[FLASH_BURST_MAX];
 
-    tmp_value = ((uint8 *)p_value);
+    if (!word_cnt || word_cnt > FLASH_BURST_MAX) {
+        return 1;
+    }
+
+    if (ADDR_2_PAGE(ai_addr) != ADDR_2_PAGE(ai_addr + word_cnt - 1)) {
+        return 1;
+    }
 
-    HalFlashWrite(ai_addr, tmp_value, 1);
-    read_flash(ai_addr, FLOPT_UINT32, &validation);
+    HalFlashWrite(ai_addr, (uint8 *)p_words, word_cnt);
+    st_flash_stats.write_cycles++;
 
-    if (validation != *(uint32 *)tmp_value) {
+    read_flash_bulk(ai_addr, validation, word_cnt);
+    st_flash_stats.verify_reads++;
+
+    if (!osal_memcmp(validation, p_words, word_cnt * HAL_FLASH_WORD_SIZE)) {
         return 1;
     }
     return 0;
 }
 
+/**
+ * @fn get_flash_stats
+ * @brief 부팅 이후 누적된 플래시 쓰기/검증/읽기 횟수를 반환
+ */
+void get_flash_stats(flash_stats_t *apst_stats)
+{
+    *apst_stats = st_flash_stats;
+}
+
 uint8 stored_conn_type(eConnType_t ai_connType)
 {
-    flash_8bit_t conn_type;
+    uint16 conn_type;
     uint8 result = 1;
-    
-    conn_type.all_bits = 0;
 
-    read_flash(FLADDR_CONNTYPE, FLOPT_UINT32, &conn_type);
-    if (conn_type.byte_1 != 0xFF && conn_type.byte_1 <= 0x03) {
+    if (settings_get(SET_KEY_CONN_TYPE, &conn_type) && conn_type <= 0x03) {
         return result;
     }
 
@@ -53,8 +139,7 @@ uint8 stored_conn_type(eConnType_t ai_connType)
         case CONN_LIGHTNING:
         case CONN_MICRO_5:
         case CONN_USB_C:
-            conn_type.byte_1 = ai_connType;
-            result = write_flash(FLADDR_CONNTYPE, &conn_type.all_bits);
+            result = settings_set(SET_KEY_CONN_TYPE, ai_connType);
             break;
         default:
             break;
@@ -63,155 +148,443 @@ uint8 stored_conn_type(eConnType_t ai_connType)
     return result;
 }
 
-void init_calib_mem_page()
-{
-    uint32 conn_type = 0;
-    uint32 calib_ref = 0;
-    read_flash(FLADDR_CONNTYPE, FLOPT_UINT32, &conn_type);
-    read_flash(FLADDR_CALIB_REF, FLOPT_UINT32, &calib_ref);
-
-    HalFlashErase(ADDR_2_PAGE(FLADDR_CALIB_SELF_ST));
-    write_flash(FLADDR_CONNTYPE, &conn_type);
-    write_flash(FLADDR_CONNTYPE, &calib_ref);
-}
-
 uint16 stored_adc_calib(uint16 calib_ref)
 {
-    flash_16bit_t calib_datas;
-
     if(calib_ref == 0) {
         /*******
          * store to self-calibration option
-         * set to calib_ref address value is 0.
+         * set to calib_ref value is 0.
          * this battery system performs self-calibration. */
-        calib_datas.all_bits = 0;
-        write_flash(FLADDR_CALIB_REF, &calib_datas.all_bits);
+        settings_set(SET_KEY_CALIB_REF, 0);
 
         /*******************
          * setup the initial calibration reference adc value
          * Maximum Voltage = 6885 * (1.25/8191) * 4 = 4.202784V
          */
-        calib_datas.high_16bit = 0xFFFF;
-        calib_datas.low_16bit = 6885;
-        write_flash(FLADDR_CALIB_SELF_ST, &calib_datas.all_bits);
-    } else {
-        calib_datas.high_16bit = 0x1000;  //reference flag
-        calib_datas.low_16bit = calib_ref;
-        write_flash(FLADDR_CALIB_REF, &calib_datas.all_bits);
+        settings_set(SET_KEY_CALIB_SELF, 6885);
+        return 6885;
     }
 
-    return calib_datas.low_16bit;
+    settings_set(SET_KEY_CALIB_REF, calib_ref);
+    return calib_ref;
 }
 
-uint16 get_calib_address()
+/**
+ * @fn search_fill_boundary
+ * @brief 앞쪽 주소부터 빈틈없이 기록되는 영역에서 처음으로 비어있는 주소를 이진탐색
+ *        영역은 페이지 단위로만 지워지므로 기록된 부분은 항상 연속됨.
+ *        한 페이지(512word) 탐색시 최대 10번의 읽기로 끝남.
+ * 
+ * @param st_addr: 탐색할 영역의 시작 주소
+ * @param end_addr: 탐색할 영역의 마지막 주소
+ * 
+ * @return 첫번째 빈 주소, 영역이 가득 찼다면 end_addr + 1
+ */
+uint16 search_fill_boundary(uint16 st_addr, uint16 end_addr)
 {
-    flash_16bit_t flash_value;
-    uint16 i;
-    for (i = FLADDR_CALIB_SELF_ED; i >= FLADDR_CALIB_SELF_ST; i--) {
-        read_flash(i, FLOPT_UINT32, &flash_value.all_bits);
-        if (flash_value.all_bits != EMPTY_FLASH) { break; }
+    uint16 low = st_addr;
+    uint16 high = end_addr + 1;
+    uint16 mid;
+    uint32 flash_val;
+
+    while (low < high) {
+        mid = low + ((high - low) >> 1);
+        read_flash(mid, FLOPT_UINT32, &flash_val);
+
+        if (flash_val == EMPTY_FLASH) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
     }
 
-     if (i < FLADDR_CALIB_SELF_ST) {
-        //not found calibration value
-        return 0;
+    return low;
+}
+
+uint8 load_flash_conntype() 
+{
+    uint16 conn_type;
+
+    if (!settings_get(SET_KEY_CONN_TYPE, &conn_type)) {
+        return 0xFF;
     }
 
-    return i;
+    return (uint8)conn_type;
 }
 
-uint16 search_self_calib()
+void erase_flash_log_area()
 {
-    flash_16bit_t flash_value;
-    uint16 calib_addr = get_calib_address();
+    uint8 pg;
+    pg = ADDR_2_PAGE(FLADDR_CALIB_REF);
+    for(; pg <= ADDR_2_PAGE(FLADDR_LOGDATA_ED); pg++) {
+        flash_page_erase(pg);
+    }
 
-    if (!calib_addr) {
-        return 0;
+    //설정 페이지도 지워졌으므로 RAM index 초기화
+    settings_init();
+}
+
+/**
+ * @fn flash_page_erase
+ * @brief 페이지를 지우고 페이지 첫 word에 지우기 횟수를 증가시켜 다시 기록
+ *        기록된 횟수가 없는 페이지는 get_page_wear의 추정값부터 시작함.
+ * 
+ * @return 해당 페이지의 누적 지우기 횟수
+ */
+uint32 flash_page_erase(uint8 pg)
+{
+    return flash_page_erase_near(pg, pg - 1, pg + 1);
+}
+
+/**
+ * @fn flash_page_erase_near
+ * @brief flash_page_erase와 같음, 기록된 횟수가 없을때 추정에 사용할 이웃 페이지를 지정
+ *        (ring의 첫/마지막 페이지처럼 주소상 이웃이 다른 용도로 쓰이는 경우)
+ * 
+ * @param prev_pg, next_pg: 사용 순서상 앞/뒤 페이지
+ * 
+ * @return 해당 페이지의 누적 지우기 횟수
+ */
+uint32 flash_page_erase_near(uint8 pg, uint8 prev_pg, uint8 next_pg)
+{
+    uint32 erase_cnt, wear_word;
+
+    erase_cnt = get_page_wear_near(pg, prev_pg, next_pg);
+    HalFlashErase(pg);
+
+    if (erase_cnt < FLASH_WEAR_MAX) {
+        erase_cnt++;
     }
-    read_flash(calib_addr, FLOPT_UINT32, &flash_value.all_bits);
-    
-    if(flash_value.high_16bit != 0xFFFF) {
-        return flash_value.high_16bit;
+    wear_word = FLASH_WEAR_WORD(erase_cnt);
+    write_flash_burst(PAGE_2_ADDR(pg) + FLASH_WEAR_OFFSET, &wear_word, 1);
+
+    return erase_cnt;
+}
+
+/**
+ * @fn read_page_wear
+ * @brief 페이지 wear word의 지우기 횟수를 읽음
+ * 
+ * @return 유효=TRUE || 기록 없음 또는 기록 도중 끊김=FALSE
+ */
+static uint8 read_page_wear(uint8 pg, uint32 *p_cnt)
+{
+    uint32 wear_word;
+
+    read_flash(PAGE_2_ADDR(pg) + FLASH_WEAR_OFFSET, FLOPT_UINT32, &wear_word);
+    if (wear_word != FLASH_WEAR_WORD(wear_word & 0xFFFF)) {
+        return FALSE;
     }
 
-    return flash_value.low_16bit;
+    *p_cnt = wear_word & 0xFFFF;
+    return TRUE;
+}
+
+/**
+ * @fn get_page_wear
+ * @brief 페이지의 누적 지우기 횟수, 기록이 없거나 깨진 페이지는 주소상 이웃 페이지로 추정
+ */
+uint32 get_page_wear(uint8 pg)
+{
+    return get_page_wear_near(pg, pg - 1, pg + 1);
 }
 
-void update_self_calibration(uint8 calib_status, uint16 adc_value)
+/**
+ * @fn get_page_wear_near
+ * @brief 페이지의 누적 지우기 횟수
+ *        기록이 없거나 깨진 페이지는 이웃 페이지 중 큰 횟수 - 1로 추정함.
+ *        순서대로 지워지는 로그/설정 페이지에서는 앞 페이지가 이미 한번 더 지워졌으므로
+ *        지우기 직후 전원이 끊긴 페이지의 횟수가 복구되고, 이웃도 모르는 페이지(처음 사용)는 0.
+ * 
+ * @param prev_pg, next_pg: 사용 순서상 앞/뒤 페이지, wear counter 영역 밖이면 사용하지 않음
+ */
+uint32 get_page_wear_near(uint8 pg, uint8 prev_pg, uint8 next_pg)
 {
-    flash_16bit_t calib_datas;
-    uint16 calib_addr;
-    
-    //check current calibration value type.
-    //0: reference 1: self
-    if(!calib_status) {
-        //delete reference calibration value
-        calib_datas.all_bits = 0;
-        write_flash(FLADDR_CALIB_REF, &calib_datas.all_bits);
+    uint32 erase_cnt, near_cnt = 0;
+
+    if (read_page_wear(pg, &erase_cnt)) {
+        return erase_cnt;
+    }
+
+    erase_cnt = 0;
+    if (prev_pg >= FLASH_WEAR_PG_ST && prev_pg <= FLASH_WEAR_PG_ED &&
+        read_page_wear(prev_pg, &near_cnt) && near_cnt > erase_cnt) {
+        erase_cnt = near_cnt;
+    }
+    if (next_pg >= FLASH_WEAR_PG_ST && next_pg <= FLASH_WEAR_PG_ED &&
+        read_page_wear(next_pg, &near_cnt) && near_cnt > erase_cnt) {
+        erase_cnt = near_cnt;
     }
 
-    calib_addr = get_calib_address();
-    if (!calib_addr) {
-        calib_addr = FLADDR_CALIB_SELF_ST;
+    return erase_cnt ? erase_cnt - 1 : 0;
+}
+/**
+ * @fn read_setting_hdr
+ * @brief 설정 페이지의 헤더를 읽고 유효한 설정 페이지인지 확인
+ * 
+ * @return 유효=TRUE || 설정 페이지 아님=FALSE
+ */
+static uint8 read_setting_hdr(uint16 pg_addr, setting_hdr_t *apst_hdr)
+{
+    read_flash(pg_addr + SETTING_HDR_OFFSET, FLOPT_UINT32, &apst_hdr->all_bits);
+
+    return (apst_hdr->magic == SETTING_MAGIC && apst_hdr->seq != 0xFFFF);
+}
+
+/**
+ * @fn index_setting_record
+ * @brief 플래시에서 읽은 설정 레코드 하나를 RAM index에 반영
+ *        key 검증값이 맞지 않는 레코드(기록 도중 끊긴 레코드)는 무시함.
+ */
+static void index_setting_record(uint32 word)
+{
+    setting_rec_t rec;
+
+    rec.all_bits = word;
+    if (rec.key == SET_KEY_NONE || rec.key >= SET_KEY_CNT || rec.key_inv != (uint8)~rec.key) {
+        return;
     }
 
-    read_flash(calib_addr, FLOPT_UINT32, &calib_datas.all_bits);
+    setting_vals[rec.key] = rec.value;
+    setting_valid |= (1 << rec.key);
+}
 
-    if (calib_datas.high_16bit != 0xFFFF) {
-        //보정값을 저장할 해당 메모리주소의 잔여공간이 없을경우
-        calib_addr = CALIBADDR_VALIDATION(calib_addr + 1);
-        if (calib_addr == FLADDR_CALIB_SELF_ST) {
-            init_calib_mem_page();
+/**
+ * @fn compact_settings
+ * @brief 사용중이 아닌 설정 페이지를 지우고 RAM index의 최신값만 옮겨 기록
+ *        레코드를 모두 기록한 뒤 헤더를 마지막에 기록하므로
+ *        도중에 전원이 끊겨도 이전 페이지가 그대로 유효함.
+ * 
+ * @return error=1||success=0
+ */
+static uint8 compact_settings()
+{
+    uint32 words[SET_KEY_CNT];
+    setting_rec_t rec;
+    setting_hdr_t hdr;
+    uint16 new_addr;
+    uint8 key, cnt = 0;
+
+    //설정 페이지가 없다면(이전 레이아웃) key log 페이지였던 B부터 사용
+    new_addr = (setting_addr == FLADDR_SETTING_B) ? FLADDR_SETTING_A : FLADDR_SETTING_B;
+    flash_page_erase(ADDR_2_PAGE(new_addr));
+
+    for (key = SET_KEY_NONE + 1; key < SET_KEY_CNT; key++) {
+        if (setting_valid & (1 << key)) {
+            rec.value = setting_vals[key];
+            rec.key = key;
+            rec.key_inv = ~key;
+            words[cnt++] = rec.all_bits;
         }
-        calib_datas.high_16bit = 0xFFFF;
-        calib_datas.low_16bit = adc_value;
-    }else {
-        calib_datas.high_16bit = adc_value;
     }
 
-    write_flash(calib_addr, &calib_datas.all_bits);
+    if (cnt && write_flash_burst(new_addr + SETTING_REC_OFFSET, words, cnt)) {
+        return 1;
+    }
+
+    hdr.seq = setting_seq + 1;
+    hdr.magic = SETTING_MAGIC;
+    if (write_flash_burst(new_addr + SETTING_HDR_OFFSET, &hdr.all_bits, 1)) {
+        return 1;
+    }
+
+    setting_addr = new_addr;
+    setting_seq = hdr.seq;
+    setting_wr_addr = new_addr + SETTING_REC_OFFSET + cnt;
+
+    return 0;
 }
 
-uint8 load_flash_conntype() 
+/**
+ * @fn legacy_key_log_present
+ * @brief 이전 펌웨어의 key log(FLADDR_SETTING_B 페이지)가 기록되어 있는지 확인
+ *        key는 word 0의 low_16bit부터 기록되므로 key가 1개라면 high_16bit만 비어있음.
+ *        지우기 횟수(wear word)는 이런 값이 될 수 없음.
+ */
+static uint8 legacy_key_log_present()
 {
-    flash_8bit_t conn_type;
+    flash_16bit_t key;
 
-    read_flash(FLADDR_CONNTYPE, FLOPT_UINT32, &conn_type.all_bits);
+    if (search_fill_boundary(FLADDR_SETTING_B + 1, FLADDR_SETTING_B + PG_END_OFFSET) != FLADDR_SETTING_B + 1) {
+        return TRUE;
+    }
 
-    return conn_type.byte_1;
+    read_flash(FLADDR_SETTING_B, FLOPT_UINT32, &key.all_bits);
+    return (key.high_16bit == 0xFFFF && key.low_16bit != 0xFFFF);
 }
 
-void init_flash_mems(uint16 ai_addr)
+/**
+ * @fn erase_legacy_pages
+ * @brief 이전 레이아웃의 페이지를 지움
+ *        이전 형식 페이지의 첫 word는 지우기 횟수가 아니므로 wear word 없이 지우고
+ *        이후 flash_page_erase에서 0부터 다시 셈.
+ */
+static void erase_legacy_pages(uint8 st_pg, uint8 ed_pg)
 {
     uint8 pg;
-    uint32 flash_val;
 
-    pg = ADDR_2_PAGE(ai_addr);
-    read_flash(ai_addr, FLOPT_UINT32, &flash_val);
-    if(flash_val != EMPTY_FLASH) {
+    for (pg = st_pg; pg <= ed_pg; pg++) {
         HalFlashErase(pg);
     }
+}
 
+/**
+ * @fn migrate_legacy_settings
+ * @brief 이전 고정주소 레이아웃(FLADDR_CONNTYPE, FLADDR_CALIB_*)의 값을
+ *        RAM index로 읽어 새 설정 페이지에 기록, 이전 key log는 옮기지 않음.
+ *        이전 펌웨어의 로그(헤더 없는 2word 로그)는 로그페이지 형식으로 읽을 수 없으므로
+ *        설정 페이지를 기록하기 전에 로그 영역을 한번 지움. key log 페이지를 마지막에 지우므로
+ *        도중에 전원이 끊기면 다음 부팅에서 다시 지움.
+ *        이전 값이 없더라도 설정 페이지를 기록하여 다음 부팅부터 다시 옮기지 않음.
+ */
+static void migrate_legacy_settings()
+{
+    flash_8bit_t conn_type;
+    flash_16bit_t calib;
+    uint16 boundary;
+    uint8 legacy;
+
+    read_flash(FLADDR_CONNTYPE, FLOPT_UINT32, &conn_type.all_bits);
+    if (conn_type.byte_1 != 0xFF) {
+        setting_vals[SET_KEY_CONN_TYPE] = conn_type.byte_1;
+        setting_valid |= (1 << SET_KEY_CONN_TYPE);
+    }
+
+    read_flash(FLADDR_CALIB_REF, FLOPT_UINT32, &calib.all_bits);
+    if (calib.all_bits == 0) {
+        setting_vals[SET_KEY_CALIB_REF] = 0;
+        setting_valid |= (1 << SET_KEY_CALIB_REF);
+    } else if (calib.high_16bit == 0x1000) {
+        setting_vals[SET_KEY_CALIB_REF] = calib.low_16bit;
+        setting_valid |= (1 << SET_KEY_CALIB_REF);
+    }
+
+    //self calibration은 16bit씩 차례로 기록되어있음, 마지막 값만 옮김
+    boundary = search_fill_boundary(FLADDR_CALIB_SELF_ST, FLADDR_CALIB_SELF_ED);
+    if (boundary != FLADDR_CALIB_SELF_ST) {
+        read_flash(boundary - 1, FLOPT_UINT32, &calib.all_bits);
+        setting_vals[SET_KEY_CALIB_SELF] = (calib.high_16bit != 0xFFFF) ? calib.high_16bit : calib.low_16bit;
+        setting_valid |= (1 << SET_KEY_CALIB_SELF);
+    }
+
+    legacy = (setting_valid || legacy_key_log_present());
+    if (legacy) {
+        erase_legacy_pages(ADDR_2_PAGE(FLADDR_LOGDATA_ST), ADDR_2_PAGE(FLADDR_LOGDATA_ED));
+        erase_legacy_pages(ADDR_2_PAGE(FLADDR_SETTING_B), ADDR_2_PAGE(FLADDR_SETTING_B));
+    }
+
+    //이전 값은 RAM index에 있으므로 새 설정 페이지 기록 후 이전 설정 페이지를 지움
+    if (!compact_settings() && legacy) {
+        erase_legacy_pages(ADDR_2_PAGE(FLADDR_SETTING_A), ADDR_2_PAGE(FLADDR_SETTING_A));
+    }
 }
 
-void erase_flash_range(uint16 st_addr, uint16 end_addr)
+/**
+ * @fn settings_init
+ * @brief 유효한 설정 페이지를 찾아 기록된 레코드를 한번 읽어 RAM index를 만듦
+ *        두 페이지 모두 유효하면 sequence가 큰 페이지를 사용함.
+ *        부팅시 한번만 호출, 이후 설정값 읽기는 settings_get으로 RAM에서 수행.
+ */
+void settings_init()
 {
-    uint8 offset_pg, end_pg;
-    uint8 i;
+    setting_hdr_t hdr_a, hdr_b;
+    uint8 valid_a, valid_b;
+    uint32 words[FLASH_BURST_MAX];
+    uint16 addr, end_addr;
+    uint8 cnt, i;
+
+    setting_valid = 0;
+    setting_addr = 0;
+    setting_seq = 0;
+    setting_wr_addr = 0;
+
+    valid_a = read_setting_hdr(FLADDR_SETTING_A, &hdr_a);
+    valid_b = read_setting_hdr(FLADDR_SETTING_B, &hdr_b);
+
+    if (!valid_a && !valid_b) {
+        migrate_legacy_settings();
+        return;
+    }
 
-    offset_pg = ADDR_2_PAGE(st_addr);
-    end_pg = ADDR_2_PAGE(end_addr);
+    if (valid_a && (!valid_b || (int16)(hdr_a.seq - hdr_b.seq) > 0)) {
+        setting_addr = FLADDR_SETTING_A;
+        setting_seq = hdr_a.seq;
+    } else {
+        setting_addr = FLADDR_SETTING_B;
+        setting_seq = hdr_b.seq;
+    }
 
-    for(i = offset_pg; i <= end_pg; i++) {
-        HalFlashErase(i);
+    //레코드는 빈틈없이 추가되므로 기록 경계까지 burst로 읽음
+    end_addr = search_fill_boundary(setting_addr + SETTING_REC_OFFSET, setting_addr + PG_END_OFFSET);
+    for (addr = setting_addr + SETTING_REC_OFFSET; addr < end_addr; addr += cnt) {
+        cnt = (end_addr - addr > FLASH_BURST_MAX) ? FLASH_BURST_MAX : (uint8)(end_addr - addr);
+        read_flash_bulk(addr, words, cnt);
+
+        for (i = 0; i < cnt; i++) {
+            index_setting_record(words[i]);
+        }
     }
+
+    setting_wr_addr = end_addr;
 }
 
-void erase_flash_log_area()
+/**
+ * @fn settings_get
+ * @brief RAM index에서 설정값을 읽음, 플래시 접근 없음
+ * 
+ * @param key: 읽을 설정 key
+ * @param p_value: 설정값을 받을 변수
+ * 
+ * @return 기록된 값 있음=TRUE || 없음=FALSE
+ */
+uint8 settings_get(eSetKey_t key, uint16 *p_value)
 {
-    uint8 pg;
-    pg = ADDR_2_PAGE(FLADDR_CALIB_REF);
-    for(; pg <= ADDR_2_PAGE(FLADDR_LOGDATA_ED); pg++) {
-        HalFlashErase(pg);
+    if (key == SET_KEY_NONE || key >= SET_KEY_CNT || !(setting_valid & (1 << key))) {
+        return FALSE;
     }
-}
\ No newline at end of file
+
+    *p_value = setting_vals[key];
+    return TRUE;
+}
+
+/**
+ * @fn settings_set
+ * @brief 설정값을 RAM index에 반영하고 설정 페이지 끝에 레코드 1word를 추가
+ *        현재값과 같다면 기록하지 않음, 페이지가 가득차면 compaction 수행.
+ * 
+ * @param key: 기록할 설정 key
+ * @param value: 설정값
+ * 
+ * @return error=1||success=0
+ */
+uint8 settings_set(eSetKey_t key, uint16 value)
+{
+    setting_rec_t rec;
+    uint8 result;
+
+    if (key == SET_KEY_NONE || key >= SET_KEY_CNT) {
+        return 1;
+    }
+
+    if ((setting_valid & (1 << key)) && setting_vals[key] == value) {
+        return 0;
+    }
+
+    setting_vals[key] = value;
+    setting_valid |= (1 << key);
+
+    if (!setting_addr || setting_wr_addr > setting_addr + PG_END_OFFSET) {
+        //설정 페이지가 없거나 가득참, 새 값을 포함한 최신값만 다른 페이지로 옮김
+        return compact_settings();
+    }
+
+    rec.value = value;
+    rec.key = key;
+    rec.key_inv = ~key;
+    result = write_flash_burst(setting_wr_addr, &rec.all_bits, 1);
+
+    //기록에 실패한 word도 다시 쓸 수 없으므로 다음 위치로 이동
+    setting_wr_addr++;
+
+    return result;
+}
@@ -22,9 +22,27 @@
 #define PG_END_OFFSET   0x01FF
 #define EMPTY_FLASH     0xFFFFFFFF
 
-#define ADDR_2_PAGE(address)    (address >> 9)
-#define PAGE_2_ADDR(page)       (uint16)(page << 9)
-#define ADDR_2_RECORD(address)  (address&PG_END_OFFSET)
+//write_flash_burst로 한번에 기록할 수 있는 최대 word 수
+#define FLASH_BURST_MAX 8
+
+//XDATA(HAL_FLASH_PAGE_MAP)에 한번에 매핑되는 플래시 bank 크기(byte)
+#define FLASH_BANK_SIZE ((uint16)HAL_FLASH_PAGE_PER_BANK * HAL_FLASH_PAGE_SIZE)
+
+/* page wear counter
+ * calibration/key/log 영역의 각 페이지 첫 word는 페이지 지우기 횟수로 사용됨.
+ * flash_page_erase로 페이지를 지운 직후 증가된 횟수를 다시 기록함.
+ * 하위 16bit는 횟수, 상위 16bit는 반전값이므로 기록 도중 끊긴 word는 두 값이 맞지 않음.
+ * 지운 뒤 횟수를 기록하기 전에 전원이 끊긴 페이지는 이웃 페이지의 횟수로 다시 만듦
+ * (로그 ring은 *_near 함수로 ring 상의 앞/뒤 페이지를 이웃으로 사용). */
+#define FLASH_WEAR_OFFSET   0
+#define FLASH_WEAR_MAX      0xFFFE
+#define FLASH_WEAR_WORD(cnt)    (((uint32)(uint16)~(cnt) << 16) | (uint16)(cnt))
+#define FLASH_WEAR_PG_ST    ADDR_2_PAGE(FLADDR_SETTING_A)
+#define FLASH_WEAR_PG_ED    ADDR_2_PAGE(FLADDR_LOGDATA_ED)
+
+#define ADDR_2_PAGE(address)    ((address) >> 9)
+#define PAGE_2_ADDR(page)       (uint16)((page) << 9)
+#define ADDR_2_RECORD(address)  ((address) & PG_END_OFFSET)
 
 /* flash read buffer type transfer */
 #define _32BIT_2_16BIT(__VA__) (uint16*)(&__VA__)
@@ -33,8 +51,9 @@
 /***********************
  * @common:
  * FLADDR_MIN: 사용가능한 메모리 영역의 최소 주소값
- * FLADDR_LOGKEY: 마지막 로그 기록 위치를 저장하는 메모리영역
+ * FLADDR_SETTING: 설정값 저장소(settings store)로 번갈아 사용하는 두 페이지
  * FLADDR_LOGDATA: 로그 데이터가 저장되는 메모리 영역
+ * FLADDR_CONNTYPE, FLADDR_CALIB: 이전 고정주소 설정 레이아웃, 설정 저장소로 옮길때만 읽음
  *      
  * Image A:
  * The available memory area is from 0x1000(8 page) to 0x8BFF(69 Page).
@@ -49,15 +68,12 @@
 #define FLADDR_CALIB_SELF_ST   0x1004
 #define FLADDR_CALIB_SELF_ED   0x11FF
 
-#define FLADDR_LOGKEY_ST    0x1200  //9 Page
-#define FLADDR_LOGKEY_ED    0x13FF
+#define FLADDR_SETTING_A    0x1000  //8 Page
+#define FLADDR_SETTING_B    0x1200  //9 Page
 
 #define FLADDR_LOGDATA_ST   0x1400  //10 Page
 #define FLADDR_LOGDATA_ED   0x8BFF  //69 Page 0x7800
 
-#define FLADDR_NEWLOG_ST   0x1200  //9 Page
-#define FLADDR_NEWLOG_ED   0x8BFF  //69 Page
-
 #else 
 #define FLADDR_MIN        0x8E00    //71 Page
 #define FLADDR_CONNTYPE        0x8E02
@@ -65,24 +81,51 @@
 #define FLADDR_CALIB_SELF_ST   0x8E04
 #define FLADDR_CALIB_SELF_ED   0x8FFF
 
-#define FLADDR_LOGKEY_ST    0x9000  //72 Page
-#define FLADDR_LOGKEY_ED    0x91FF
+#define FLADDR_SETTING_A    0x8E00  //71 Page
+#define FLADDR_SETTING_B    0x9000  //72 Page
 
 #define FLADDR_LOGDATA_ST   0x9200  //73 Page
 #define FLADDR_LOGDATA_ED   0xF5FF  //122 Page 0x6400
-
-#define FLADDR_NEWLOG_ST   0x9000  //72 Page
-#define FLADDR_NEWLOG_ED   0xF5FF  //122 Page
 #endif
 
-/***********
- * log addres range over validation check 
- * this address range is over the max, return first log address.
- * and valid address, return input address.
+/* settings store
+ * 설정값은 FLADDR_SETTING_A/B 페이지 중 한곳에 차례로 추가기록(append)됨.
+ * word 0: wear counter, word 1: 페이지 헤더, word 2 ~ : 설정 레코드
+ * 페이지가 가득차면 다른 페이지를 지우고 RAM에 있는 최신값만 옮겨 기록함.
+ * 부팅시 한번 읽어 RAM index를 만들고 이후 읽기는 RAM에서만 수행함.
  */
-#define LOGADDR_VALIDATION(address) (address>FLADDR_LOGDATA_ED)?FLADDR_LOGDATA_ST:address
-#define KEYADDR_VALIDATION(address) (address>FLADDR_LOGKEY_ED)?FLADDR_LOGKEY_ST:address
-#define CALIBADDR_VALIDATION(address) (address>FLADDR_CALIB_SELF_ED)?FLADDR_CALIB_SELF_ST:address
+#define SETTING_HDR_OFFSET  1
+#define SETTING_REC_OFFSET  2
+#define SETTING_MAGIC       0xFA5E  //로그 주소 범위 밖의 값, 이전 key log 값과 겹치지 않음
+
+typedef enum _SETTING_KEY {
+    SET_KEY_NONE = 0,
+    SET_KEY_CONN_TYPE,      //eConnType_t
+    SET_KEY_CALIB_REF,      //0: self-calibration, 그외: reference calibration adc 값
+    SET_KEY_CALIB_SELF,     //마지막 self-calibration adc 값
+    SET_KEY_RESERVED_4,     //사용하지 않음, 저장된 설정의 key 번호 유지용
+    SET_KEY_SOC_MAH,        //coulomb counter 남은 용량(mAh)
+    SET_KEY_CHG_TOTAL,      //누적 충전량(CC_TOTAL_UNIT mAh 단위)
+    SET_KEY_DISCHG_TOTAL,   //누적 방전량(CC_TOTAL_UNIT mAh 단위)
+    SET_KEY_CNT             //setting_valid bit 수(8)를 넘을 수 없음
+} eSetKey_t;
+
+typedef union _SETTING_RECORD {
+    struct {
+        uint32 value : 16;
+        uint32 key : 8;
+        uint32 key_inv : 8;     //~key, 기록 도중 끊긴 레코드 판별
+    };
+    uint32 all_bits;
+}setting_rec_t;
+
+typedef union _SETTING_HEADER {
+    struct {
+        uint32 seq : 16;        //compaction 할때마다 증가, 큰 값의 페이지가 유효
+        uint32 magic : 16;      //SETTING_MAGIC
+    };
+    uint32 all_bits;
+}setting_hdr_t;
 
 typedef enum FLASH_VARIABLE_OPT {
     //Flash R/W variable type option
@@ -144,21 +187,34 @@ typedef union _FLASH_TYPE8 {
     uint32 all_bits;
 }flash_8bit_t;
 
+typedef struct _FLASH_STATS {
+    uint32 write_cycles;    //HalFlashWrite 호출 횟수
+    uint32 verify_reads;    //쓰기 검증을 위한 읽기 횟수
+    uint32 read_calls;      //read_flash_bulk 호출(bank 매핑) 횟수
+    uint32 read_words;      //read_flash_bulk로 읽은 word 수
+}flash_stats_t;
+
 uint8 write_flash(uint16 ai_addr, void *p_value);
+uint8 write_flash_burst(uint16 ai_addr, uint32 *p_words, uint8 word_cnt);
 void read_flash(uint16 ai_addr, eFlash_Var_t value_type, void *p_value);
+void read_flash_bulk(uint16 ai_addr, void *p_buf, uint16 word_cnt);
+void get_flash_stats(flash_stats_t *apst_stats);
+
+void settings_init();
+uint8 settings_get(eSetKey_t key, uint16 *p_value);
+uint8 settings_set(eSetKey_t key, uint16 value);
 
 uint8 stored_conn_type(eConnType_t ai_connType);
 uint16 stored_adc_calib(uint16 calib_ref);
 uint8 load_flash_conntype();
 
-void erase_flash_range(uint16 st_addr, uint16 end_addr);
 void erase_flash_log_area();
 
-void init_flash_mems(uint16 ai_addr);
-void init_calib_mem_page();
+uint32 flash_page_erase(uint8 pg);
+uint32 flash_page_erase_near(uint8 pg, uint8 prev_pg, uint8 next_pg);
+uint32 get_page_wear(uint8 pg);
+uint32 get_page_wear_near(uint8 pg, uint8 prev_pg, uint8 next_pg);
 
-uint16 get_calib_address();
-uint16 search_self_calib();
-void update_self_calibration(uint8 calib_status, uint16 adc_value);
+uint16 search_fill_boundary(uint16 st_addr, uint16 end_addr);
 
 #endif
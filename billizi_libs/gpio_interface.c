@@ -11,7 +11,7 @@ void setup_pin()
 
     P0 = 0;
     P0SEL = BIT0|BIT1|BIT6;
-    P0INP = 0xFF;
+    P0INP = 0xFF & ~BIT2;       //P0_2 LM75 OS는 open drain이므로 pullup
     //P0DIR = BIT4|BIT5|BIT7;    //P_(4,5,7) output, use vib_motor
     P0DIR = BIT4|BIT5;          //P_(4,5) output, P_(3,7) input, use vib_sensor
 
@@ -15,6 +15,7 @@
 /* batt upper snu v1.0.0 gpio allocation. */
 /* definition of battery control gpio register */
 //						   	P0_0 // ADC?
+#define TEMP_OS_ALERT      	P0_2 //INPUT, LM75 OS(open drain, active low), port0 interrupt
 #define RETR_CABLE_STATUS  	P0_3 //INPUT
 #define RETR_TEST_EN       	P0_4 //OUTPUT
 #define EN_CONN_RETR       	P0_5 //OUTPUT
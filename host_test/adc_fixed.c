@@ -0,0 +1,190 @@
+#include "sim_flash.h"
+#include "flash_interface.h"
+#include "adc_interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+/* adc_fixed - 고정소수점 전압/전류 변환의 정확도와 속도
+ * 이전 float 변환(convert_voltage, read_current, setup_calib_value의 float 계산)을 기준으로
+ * adc 전 범위(0 ~ ADC_FULL_SCALE)에 대한 최대/평균 오차를 보정값별로 출력하고,
+ * 두 방식의 변환 1회당 시간을 비교함. 오차가 MAX_ERR를 넘거나 외부전압 판정 경계가 다르면 실패.
+ * host는 FPU가 있으므로 float가 느리지 않음, 8051에서는 float 연산이 소프트웨어 라이브러리로 수행됨. */
+
+//이전 float 변환 상수
+#define REF125_UNIT     (1.25/8191)
+#define SHUNT_R_VAL     (0.025)
+#define MAX_BATT_V      (4.2)
+#define BATT_REF_V      (3.75)
+
+#define MAX_ERR         1.0     //허용 최대 오차 [mV], [mA]
+
+static uint16 fake_adc[2];      //[0]: 배터리측/외부전압, [1]: 인덕터측
+
+uint16 HalAdcRead(uint8 channel, uint8 resolution)
+{
+    return (channel == ADC_SHUNT_R && IO_ADC_INDUCTOR_SIDE) ? fake_adc[1] : fake_adc[0];
+}
+
+void HalAdcSetReference(uint8 reference)
+{
+}
+
+void delay_us(uint16 microSecs)
+{
+}
+
+static float ref_calib(uint8 calib_opt, uint16 calib_value)
+{
+    float adc_voltage = calib_value * REF125_UNIT * BATT_RATIO_V;
+
+    if (!calib_value) {
+        return 0;
+    }
+    return (calib_opt ? MAX_BATT_V : BATT_REF_V) / adc_voltage;
+}
+
+static float ref_batt_mv(uint16 adc, float g_calib)
+{
+    float f_voltage = adc * REF125_UNIT * BATT_RATIO_V;
+
+    if (g_calib != 0) {
+        f_voltage *= g_calib;
+    }
+    return f_voltage * 1000;
+}
+
+static float ref_ext_mv(uint16 adc)
+{
+    return adc * REF125_UNIT * EXT_RATIO_V * 1000;
+}
+
+static float ref_curr_ma(uint16 diff)
+{
+    return ((diff * REF125_UNIT * BATT_RATIO_V) / SHUNT_R_VAL) * 1000;
+}
+
+typedef struct {
+    double max;
+    double sum;
+    long n;
+} err_t;
+
+static void err_add(err_t *apst_err, double fixed, double ref)
+{
+    double e = fabs(fixed - ref);
+
+    apst_err->max = (e > apst_err->max) ? e : apst_err->max;
+    apst_err->sum += e;
+    apst_err->n++;
+}
+
+static int err_print(const char *name, const char *calib, const char *unit, err_t *apst_err)
+{
+    printf("%-8s %-12s %9.3f %9.3f  %s\n", name, calib, apst_err->max, apst_err->sum / apst_err->n, unit);
+
+    return apst_err->max > MAX_ERR;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+    static const struct { uint8 self; uint16 adc; } calibs[] = {
+        {TRUE, 6700}, {TRUE, 6885}, {TRUE, 7050}, {FALSE, 6000}, {FALSE, 6143}, {FALSE, 6300},
+    };
+    volatile float f_sink = 0;
+    volatile uint32 i_sink = 0;
+    char name[16];
+    err_t err;
+    float g_calib;
+    double t_float, t_fixed;
+    uint16 a, c;
+    int rep, fail = 0;
+
+    sim_flash_reset();
+    settings_init();
+    adc_init();
+
+    printf("%-8s %-12s %9s %9s\n", "channel", "calib", "max|err|", "mean|err|");
+
+    setup_calib_value(TRUE, 0);
+    memset(&err, 0, sizeof(err));
+    for (a = 0; a <= ADC_FULL_SCALE; a++) {
+        fake_adc[0] = a;
+        err_add(&err, read_voltage(READ_BATT_SIDE), ref_batt_mv(a, 0));
+    }
+    fail |= err_print("BATT", "none", "mV", &err);
+
+    for (c = 0; c < sizeof(calibs) / sizeof(calibs[0]); c++) {
+        setup_calib_value(calibs[c].self, calibs[c].adc);
+        g_calib = ref_calib(calibs[c].self, calibs[c].adc);
+        memset(&err, 0, sizeof(err));
+        for (a = 0; a <= ADC_FULL_SCALE; a++) {
+            fake_adc[0] = a;
+            err_add(&err, read_voltage(READ_BATT_SIDE), ref_batt_mv(a, g_calib));
+        }
+        snprintf(name, sizeof(name), "%s %u", calibs[c].self ? "self" : "ref", calibs[c].adc);
+        fail |= err_print("BATT", name, "mV", &err);
+    }
+
+    memset(&err, 0, sizeof(err));
+    for (a = 0; a <= ADC_FULL_SCALE; a++) {
+        fake_adc[0] = a;
+        err_add(&err, read_voltage(READ_EXT), ref_ext_mv(a));
+    }
+    fail |= err_print("EXT", "-", "mV", &err);
+
+    //전류: 배터리측 5000 고정, 인덕터측을 올려가며 0xFFFF mA 직전까지, 두 측정 방식 모두
+    fake_adc[0] = 5000;
+    for (c = ADC_CURR_SEQUENTIAL; c <= ADC_CURR_INTERLEAVE; c++) {
+        adc_curr_mode(c);
+        memset(&err, 0, sizeof(err));
+        for (a = 0; ref_curr_ma(a) < 0xFFFF; a++) {
+            fake_adc[1] = fake_adc[0] + a;
+            err_add(&err, read_current(READ_CURR_CHG), ref_curr_ma(a));
+        }
+        fail |= err_print("CURR", (c == ADC_CURR_INTERLEAVE) ? "interleave" : "sequential", "mA", &err);
+    }
+
+    if (ext_voltage_analysis(20000) != EXT_MIN_V || ext_voltage_analysis(19999) != EXT_COMM_V ||
+        ext_voltage_analysis(8000) != EXT_COMM_V || ext_voltage_analysis(7999) != EXT_ZERO_V) {
+        fail = 1;
+    }
+    printf("thresholds: 20000mV %d, 19999mV %d, 8000mV %d, 7999mV %d\n",
+           ext_voltage_analysis(20000), ext_voltage_analysis(19999),
+           ext_voltage_analysis(8000), ext_voltage_analysis(7999));
+
+    //변환 1회 시간, adc 읽기를 제외한 변환식만 비교
+    setup_calib_value(TRUE, 6885);
+    g_calib = ref_calib(TRUE, 6885);
+    t_float = now_sec();
+    for (rep = 0; rep < 2000; rep++) {
+        for (a = 0; a <= ADC_FULL_SCALE; a++) {
+            f_sink += ref_batt_mv(a, g_calib);
+        }
+    }
+    t_float = now_sec() - t_float;
+
+    t_fixed = now_sec();
+    for (rep = 0; rep < 2000; rep++) {
+        for (a = 0; a <= ADC_FULL_SCALE; a++) {
+            i_sink += (uint16)(((uint32)a * BATT_MV_Q + ADC_Q_ROUND) >> ADC_Q_SHIFT);
+        }
+    }
+    t_fixed = now_sec() - t_fixed;
+
+    printf("host conversion: float %.2f ns, fixed %.2f ns\n",
+           t_float * 1e9 / (2000.0 * (ADC_FULL_SCALE + 1)), t_fixed * 1e9 / (2000.0 * (ADC_FULL_SCALE + 1)));
+    printf("Q constants: BATT_MV_Q %lu, EXT_MV_Q %lu, CURR_MA_Q %lu\n",
+           (unsigned long)BATT_MV_Q, (unsigned long)EXT_MV_Q, (unsigned long)CURR_MA_Q);
+
+    return fail;
+}
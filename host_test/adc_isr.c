@@ -0,0 +1,197 @@
+#include "sim_adc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* adc_isr - background sampler 인터럽트 변환 순서 시험
+ * adc_sampler_tick과 ADC 완료 인터럽트(adc_sampler_isr)를 변환 시간과 함께 흉내내어 다음을 확인함.
+ *  - shunt 측 변환은 IO가 정확히 한쪽만 켜진 상태에서만 수행됨
+ *  - IO 전환 후 ADC_SETTLE_US 안에 시작된 결과 사용 변환이 없음 (안정화 변환/외부전압 변환으로 대기)
+ *  - 주기가 끝나면 shunt IO가 모두 꺼지고, 한 주기의 변환이 ADC_SAMPLE_PERIOD 안에 끝남
+ * 그리고 백색잡음과 공통 전압 ripple(충전 전류 ripple)을 넣어 sequential/interleave 방식과
+ * blocking/sampler 경로의 전류 평균과 표준편차를 비교함.
+ * 충전 완료 판정(main_task.h CHG_TERM_CNT)의 근거로 sampler 값이 실제 전류보다 TERM_MARGIN_MA 이상
+ * 낮게 읽힌 최장 연속 tick 수(term run)를 구함. 실제 전류가 완료 기준보다 TERM_MARGIN_MA 이상 높으면
+ * 연속 판정 횟수가 이보다 커야 잘못 완료되지 않음.
+ *
+ * 인자가 없으면 ripple 없음, 8 LSB @ 100Hz, 20 LSB @ 300Hz 세 경우를 차례로 실행함.
+ *
+ * usage: adc_isr [ripple 진폭(LSB)] [ripple 주파수(Hz)] */
+
+#define ADC_SETTLE_US   50      //open_adc_driver의 안정화 대기와 같은 값
+#define TICKS           20000
+#define WARM_TICKS      500
+#define BLOCKING_READS  2000
+#define TERM_MARGIN_MA  10      //sequential 잡음 약 1 sd
+#define TERM_CNT        100     //main_task.h CHG_TERM_CNT
+
+//배터리측/외부전압 adc, 인덕터측은 CURR_LSB만큼 높음
+#define BATT_ADC        6800.3
+#define CURR_LSB        9.83
+#define EXT_ADC         5000.4
+#define NOISE_LSB       3.0
+
+typedef struct {
+    double sum;
+    double sq;
+    long n;
+} stat_t;
+
+static double ripple = 8.0;
+static double ripple_hz = 100;
+static long io_err, unsettled, io_left, overrun;
+static uint32 rnd_state = 7;
+
+static double uniform(void)
+{
+    rnd_state = rnd_state * 1103515245UL + 12345;
+    return (((rnd_state >> 8) & 0xFFFFFF) + 0.5) / 16777216.0;
+}
+
+static double gauss(void)
+{
+    return sqrt(-2 * log(uniform())) * cos(6.283185307179586 * uniform());
+}
+
+uint16 sim_adc_sample(uint8 channel, uint16 conv_us)
+{
+    //변환 구간 중앙 시각의 ripple
+    double t = (sim_adc_now + conv_us / 2) * 1e-6;
+    double v;
+    long adc_val;
+
+    if (channel == ADC_EXTERNAL) {
+        v = EXT_ADC;
+    } else {
+        if (IO_ADC_BATT_SIDE == IO_ADC_INDUCTOR_SIDE) {
+            io_err++;
+        }
+        //결과를 버리는 안정화 변환(decimation 256)은 검사하지 않음
+        if (conv_us == SIM_ADC_DEC512_US && sim_adc_now - sim_adc_io_time < ADC_SETTLE_US) {
+            unsettled++;
+        }
+        v = (IO_ADC_BATT_SIDE ? BATT_ADC : BATT_ADC + CURR_LSB) + ripple * sin(6.283185307179586 * ripple_hz * t);
+    }
+
+    adc_val = lround(v + NOISE_LSB * gauss());
+    return (uint16)((adc_val < 0) ? 0 : adc_val);
+}
+
+static void stat_add(stat_t *apst_st, double x)
+{
+    apst_st->sum += x;
+    apst_st->sq += x * x;
+    apst_st->n++;
+}
+
+static double stat_mean(stat_t *apst_st)
+{
+    return apst_st->sum / apst_st->n;
+}
+
+static double stat_sd(stat_t *apst_st)
+{
+    double m = stat_mean(apst_st);
+    double v = apst_st->sq / apst_st->n - m * m;
+
+    return (v > 0) ? sqrt(v) : 0;
+}
+
+//한 주기 진행, 주기 사이 간격은 OSAL timer처럼 0 ~ 2.2ms 늦어질 수 있음
+static void tick(long n)
+{
+    uint32 t0 = sim_adc_now;
+
+    sim_adc_tick();
+    if (IO_ADC_BATT_SIDE || IO_ADC_INDUCTOR_SIDE) {
+        io_left++;
+    }
+    if (sim_adc_now - t0 >= ADC_SAMPLE_PERIOD * 1000UL) {
+        overrun++;
+    }
+    sim_adc_now = t0 + ADC_SAMPLE_PERIOD * 1000UL + 370 * (n % 7);
+}
+
+static long run(uint8 mode, const char *name, stat_t *apst_samp, double true_ma)
+{
+    stat_t blk = {0, 0, 0};
+    long n, convs, term = 0, term_max = 0;
+    double curr;
+
+    adc_curr_mode(mode);
+
+    for (n = 0; n < BLOCKING_READS; n++) {
+        sim_adc_now += 12300;
+        stat_add(&blk, read_current(READ_CURR_CHG));
+    }
+
+    adc_sampler_start();
+    for (n = 0; n < WARM_TICKS; n++) {
+        tick(n);
+    }
+    memset(apst_samp, 0, sizeof(*apst_samp));
+    convs = sim_adc_convs;
+    for (n = 0; n < TICKS; n++) {
+        tick(n);
+        //충전 완료 판정처럼 매 tick 읽음
+        curr = read_current(READ_CURR_CHG);
+        term = (curr <= true_ma - TERM_MARGIN_MA) ? term + 1 : 0;
+        if (term > term_max) {
+            term_max = term;
+        }
+        if (n % 10 == 0) {
+            stat_add(apst_samp, curr);
+        }
+    }
+    convs = sim_adc_convs - convs;
+    adc_sampler_stop();
+
+    printf("%-11s %9.1f %8.2f %9.1f %8.2f %10.1f %9ld\n", name, stat_mean(&blk), stat_sd(&blk),
+           stat_mean(apst_samp), stat_sd(apst_samp), (double)convs / TICKS, term_max);
+
+    return term_max;
+}
+
+int main(int argc, char **argv)
+{
+    //ripple 진폭(LSB), 주파수(Hz)
+    static const double scenarios[][2] = {{0, 100}, {8, 100}, {20, 300}};
+    double true_ma = CURR_LSB * CURR_MA_Q / (1 << CURR_Q_SHIFT);
+    stat_t seq, ilv;
+    uint8 i, cnt = sizeof(scenarios) / sizeof(scenarios[0]);
+    int fail = 0;
+
+    sim_adc_reset();
+    adc_init();
+
+    printf("true %.1f mA, white %.1f LSB, sd in mA, term run: ticks %d mA below true (limit %d)\n",
+           true_ma, NOISE_LSB, TERM_MARGIN_MA, TERM_CNT);
+    for (i = 0; i < cnt; i++) {
+        ripple = (argc > 1) ? atof(argv[1]) : scenarios[i][0];
+        ripple_hz = (argc > 2) ? atof(argv[2]) : scenarios[i][1];
+
+        printf("common-mode ripple %.1f LSB @ %.0f Hz\n", ripple, ripple_hz);
+        printf("%-11s %9s %8s %9s %8s %10s %9s\n", "mode", "blk mA", "blk sd", "samp mA", "samp sd",
+               "conv/tick", "term run");
+        //기본 방식(sequential)의 잡음으로 잘못된 충전 완료가 나지 않아야 함
+        if (run(ADC_CURR_SEQUENTIAL, "sequential", &seq, true_ma) >= TERM_CNT) {
+            fail = 1;
+        }
+        run(ADC_CURR_INTERLEAVE, "interleave", &ilv, true_ma);
+
+        if (fabs(stat_mean(&seq) - true_ma) > 10 || fabs(stat_mean(&ilv) - true_ma) > 10) {
+            fail = 1;
+        }
+        //ripple이 filter 대역을 넘어 커지면 interleave가 공통 ripple을 상쇄하여 더 작아야 함
+        if (ripple >= 20 && stat_sd(&ilv) >= stat_sd(&seq)) {
+            fail = 1;
+        }
+        if (argc > 1) {
+            break;
+        }
+    }
+    printf("io both/none %ld, unsettled %ld, io left on %ld, overrun %ld\n",
+           io_err, unsettled, io_left, overrun);
+
+    return fail || io_err || unsettled || io_left || overrun;
+}
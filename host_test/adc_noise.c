@@ -0,0 +1,183 @@
+#include "sim_adc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* adc_noise - oversampling filter의 잡음 감소 측정
+ * 배터리측 adc trace를 변환 순서대로 넣으며 filter 적용 전(변환 1회, 이전 SAMPLING_CNT 평균)과
+ * background sampler의 filter 설정별 출력(read_adc_hr)의 표준편차를 LSB 단위로 비교함.
+ * trace는 배터리측 변환에만 사용되고 끝에 닿으면 처음부터 다시 사용함.
+ * 기본 filter 설정의 잡음이 변환 1회의 절반을 넘거나 평균이 0.5 LSB 넘게 틀어지면 실패.
+ *
+ * usage: adc_noise [trace 파일] */
+
+#define TRACE_MAX   65536
+#define TICKS       4000
+#define WARM_TICKS  200
+
+typedef struct {
+    uint8 os_bits;
+    uint8 iir_shift;
+    uint8 burst;
+} filt_cfg_t;
+
+typedef struct {
+    double sum;
+    double sq;
+    long n;
+} stat_t;
+
+static uint16 trace[TRACE_MAX];
+static long trace_len, trace_pos;
+
+uint16 sim_adc_sample(uint8 channel, uint16 conv_us)
+{
+    if (channel == ADC_EXTERNAL) {
+        return 5000;
+    }
+    if (!IO_ADC_BATT_SIDE) {
+        return 6600;
+    }
+    if (trace_pos >= trace_len) {
+        trace_pos = 0;
+    }
+    return trace[trace_pos++];
+}
+
+static long load_trace(const char *path)
+{
+    char line[256];
+    FILE *fp = fopen(path, "r");
+
+    if (!fp) {
+        return 0;
+    }
+    trace_len = 0;
+    while (trace_len < TRACE_MAX && fgets(line, sizeof(line), fp)) {
+        if (line[0] != '#' && line[0] != '\n') {
+            trace[trace_len++] = (uint16)atoi(line);
+        }
+    }
+    fclose(fp);
+
+    return trace_len;
+}
+
+static void stat_add(stat_t *apst_st, double x)
+{
+    apst_st->sum += x;
+    apst_st->sq += x * x;
+    apst_st->n++;
+}
+
+static double stat_mean(stat_t *apst_st)
+{
+    return apst_st->sum / apst_st->n;
+}
+
+static double stat_sd(stat_t *apst_st)
+{
+    double m = stat_mean(apst_st);
+    double v = apst_st->sq / apst_st->n - m * m;
+
+    return (v > 0) ? sqrt(v) : 0;
+}
+
+static void report(const char *name, long convs, stat_t *apst_st, double sd_raw)
+{
+    double sd = stat_sd(apst_st);
+
+    printf("%-24s %6ld %9.2f %7.3f %6.2f\n", name, convs, stat_mean(apst_st), sd,
+           (sd > 0) ? log2(sd_raw / sd) : 99.0);
+}
+
+static stat_t run_blocking(uint8 samp_cnt, long cnt)
+{
+    stat_t st = {0, 0, 0};
+    long i;
+
+    for (i = 0; i < cnt; i++) {
+        stat_add(&st, read_adc_sampling(samp_cnt, READ_BATT_SIDE));
+    }
+    return st;
+}
+
+static stat_t run_sampler(const filt_cfg_t *apst_cfg)
+{
+    stat_t st = {0, 0, 0};
+    uint16 t;
+
+    adc_filter_config(READ_BATT_SIDE, apst_cfg->os_bits, apst_cfg->iir_shift, apst_cfg->burst);
+    adc_sampler_start();
+    for (t = 0; t < WARM_TICKS + TICKS; t++) {
+        sim_adc_tick();
+        if (t >= WARM_TICKS) {
+            stat_add(&st, (double)read_adc_hr(READ_BATT_SIDE) / (1 << ADC_HR_SHIFT));
+        }
+    }
+    adc_sampler_stop();
+
+    return st;
+}
+
+int main(int argc, char **argv)
+{
+    static const filt_cfg_t cfgs[] = {
+        {0, 0, 4}, {1, 0, 4}, {2, 0, 4}, {3, 0, 4}, {4, 0, 8},
+        {ADC_SHUNT_OS_BITS, ADC_SHUNT_IIR_SHIFT, ADC_SHUNT_BURST}, {2, 4, 4}, {0, 4, 4},
+    };
+    const char *path = (argc > 1) ? argv[1] : "traces/batt_side_synth.txt";
+    stat_t st, st_raw;
+    double trace_mean = 0, sd_raw;
+    char name[32];
+    int fail = 0;
+    long i;
+    uint8 c;
+
+    if (!load_trace(path)) {
+        printf("no trace: %s\n", path);
+        return 1;
+    }
+    for (i = 0; i < trace_len; i++) {
+        trace_mean += trace[i];
+    }
+    trace_mean /= trace_len;
+
+    sim_adc_reset();
+    adc_init();
+    adc_curr_mode(ADC_CURR_SEQUENTIAL);
+
+    printf("trace %s, %ld samples, mean %.2f\n", path, trace_len, trace_mean);
+    printf("%-24s %6s %9s %7s %6s\n", "filter", "conv", "mean", "sd(LSB)", "+bits");
+
+    //before: 변환 1회, 이전 read_adc_sampling 평균
+    trace_pos = 0;
+    st_raw = run_blocking(1, trace_len);
+    sd_raw = stat_sd(&st_raw);
+    report("raw conversion", 1, &st_raw, sd_raw);
+
+    st = run_blocking(SAMPLING_CNT, trace_len / SAMPLING_CNT);
+    report("mean of SAMPLING_CNT", SAMPLING_CNT, &st, sd_raw);
+    st = run_blocking(10, trace_len / 10);
+    report("mean of 10", 10, &st, sd_raw);
+
+    //after: sampler filter, os_bits/iir_shift/burst
+    for (c = 0; c < sizeof(cfgs) / sizeof(cfgs[0]); c++) {
+        st = run_sampler(&cfgs[c]);
+        snprintf(name, sizeof(name), "os %u iir %u burst %u%s", cfgs[c].os_bits, cfgs[c].iir_shift,
+                 cfgs[c].burst, (cfgs[c].os_bits == ADC_SHUNT_OS_BITS && cfgs[c].iir_shift == ADC_SHUNT_IIR_SHIFT
+                                 && cfgs[c].burst == ADC_SHUNT_BURST) ? " *" : "");
+        report(name, 1L << (cfgs[c].os_bits << 1), &st, sd_raw);
+
+        if (fabs(stat_mean(&st) - trace_mean) > 0.5) {
+            fail = 1;
+        }
+        if (cfgs[c].os_bits == ADC_SHUNT_OS_BITS && cfgs[c].iir_shift == ADC_SHUNT_IIR_SHIFT &&
+            stat_sd(&st) > sd_raw / 2) {
+            fail = 1;
+        }
+    }
+    printf("* default battery/inductor side setting, conv: conversions per filter output\n");
+
+    return fail;
+}
@@ -0,0 +1,141 @@
+#include "sim_adc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* ext_class - 외부전압 판정기(ext_class_update)의 hysteresis/debounce 시험
+ * background sampler로 외부전압 변환을 흉내내며 매 tick 판정기를 실행하고,
+ * 같은 filter 출력에 고정 기준(ext_voltage_analysis)을 적용한 경우와 판정 변경 횟수를 비교함.
+ * 외부전압 시나리오(60초, 변환마다 NOISE_MV rms 잡음):
+ *   24V -> 20V 근처에서 천천히 흔들림 -> 12V -> 8V 근처에서 흔들림(중간에 10ms 0V 순간 끊김) -> 0V -> 24V
+ * 실제 전압이 바뀐 3번만 판정이 바뀌어야 하고, 각 변경은 STEP_LATENCY_MS 안에 일어나야 함.
+ *
+ * usage: ext_class [잡음(mV rms)] */
+
+#define TICKS           6000    //60초
+#define NOISE_MV        300.0
+#define DWELL_MV        200.0   //20V/8V 근처에서 흔들리는 진폭
+#define STEP_LATENCY_MS 100
+
+typedef struct {
+    long tick;          //실제 전압 변경 시각(tick)
+    uint8 cls;          //변경 후 판정
+} step_t;
+
+static const step_t steps[] = {
+    {2000, EXT_COMM_V}, {4500, EXT_ZERO_V}, {5200, EXT_MIN_V},
+};
+
+static double noise_mv = NOISE_MV;
+static uint32 rnd_state = 11;
+
+static double uniform(void)
+{
+    rnd_state = rnd_state * 1103515245UL + 12345;
+    return (((rnd_state >> 8) & 0xFFFFFF) + 0.5) / 16777216.0;
+}
+
+static double gauss(void)
+{
+    return sqrt(-2 * log(uniform())) * cos(6.283185307179586 * uniform());
+}
+
+//시각 t(us)의 실제 외부전압(mV)
+static double ext_mv(uint32 t)
+{
+    double s = t * 1e-6;
+
+    if (s < 5) {
+        return 24000;
+    } else if (s < 20) {
+        return EXT_MIN_MV + DWELL_MV * sin(6.283185307179586 * 0.2 * s);
+    } else if (s < 30) {
+        return 12000;
+    } else if (s < 45) {
+        if (s >= 40 && s < 40.01) {
+            return 0;
+        }
+        return EXT_COMM_MV + DWELL_MV * sin(6.283185307179586 * 0.2 * s);
+    } else if (s < 52) {
+        return 0;
+    }
+    return 24000;
+}
+
+uint16 sim_adc_sample(uint8 channel, uint16 conv_us)
+{
+    double v;
+    long adc_val;
+
+    if (channel != ADC_EXTERNAL) {
+        return IO_ADC_BATT_SIDE ? 6800 : 6810;
+    }
+
+    v = ext_mv(sim_adc_now + conv_us / 2) + noise_mv * gauss();
+    adc_val = lround(v * ADC_FULL_SCALE / ((double)REF125_MV * EXT_RATIO_V));
+    if (adc_val < 0) {
+        adc_val = 0;
+    }
+    return (uint16)((adc_val > ADC_FULL_SCALE) ? ADC_FULL_SCALE : adc_val);
+}
+
+int main(int argc, char **argv)
+{
+    long n, hard_chg = 0, cls_chg = 0, latency;
+    uint8 hard, hard_last, cls, cls_last;
+    uint8 s = 0;
+    uint32 t0;
+    int fail = 0;
+
+    if (argc > 1) {
+        noise_mv = atof(argv[1]);
+    }
+
+    sim_adc_reset();
+    adc_init();
+    adc_sampler_start();
+
+    cls_last = ext_voltage_result();
+    hard_last = cls_last;
+    printf("noise %.0f mV rms, %d ticks of %d ms\n", noise_mv, TICKS, ADC_SAMPLE_PERIOD);
+    printf("%-10s %6s %6s %12s\n", "time(s)", "from", "to", "latency(ms)");
+
+    for (n = 0; n < TICKS; n++) {
+        t0 = sim_adc_now;
+        sim_adc_tick();
+        ext_class_update();
+        sim_adc_now = t0 + ADC_SAMPLE_PERIOD * 1000UL;
+
+        hard = ext_voltage_analysis(read_voltage(READ_EXT));
+        if (hard != hard_last) {
+            hard_chg++;
+            hard_last = hard;
+        }
+
+        cls = ext_voltage_result();
+        if (cls == cls_last) {
+            continue;
+        }
+        cls_chg++;
+
+        //실제 변경 이전에 바뀌었거나 예상과 다른 판정이면 실패
+        if (s >= sizeof(steps) / sizeof(steps[0]) || n < steps[s].tick || cls != steps[s].cls) {
+            printf("%-10.2f %6u %6u %12s\n", n * ADC_SAMPLE_PERIOD / 1000.0, cls_last, cls, "unexpected");
+            fail = 1;
+        } else {
+            latency = (n - steps[s].tick + 1) * ADC_SAMPLE_PERIOD;
+            printf("%-10.2f %6u %6u %12ld\n", n * ADC_SAMPLE_PERIOD / 1000.0, cls_last, cls, latency);
+            if (latency > STEP_LATENCY_MS) {
+                fail = 1;
+            }
+            s++;
+        }
+        cls_last = cls;
+    }
+    adc_sampler_stop();
+
+    printf("class changes: fixed threshold %ld, classifier %ld (expected %u)\n",
+           hard_chg, cls_chg, (unsigned)(sizeof(steps) / sizeof(steps[0])));
+
+    return fail || s != sizeof(steps) / sizeof(steps[0]);
+}
@@ -0,0 +1,97 @@
+#include "sim_flash.h"
+#include "flash_interface.h"
+#include <stdio.h>
+
+/* fill_boundary - 기록 경계 탐색(search_fill_boundary)의 플래시 읽기 횟수 측정
+ * 이전 방식(영역 끝에서부터 word 단위로 거꾸로 읽기)과 이진탐색을
+ * 설정 기록 영역, self calibration 영역에 대해 비어있을때/절반/가득 찼을때 비교함.
+ * 모든 기록량(0 ~ 영역 크기)에 대해 두 방식의 결과가 같은지도 확인함. */
+
+static long read_calls(void)
+{
+    flash_stats_t stats;
+
+    get_flash_stats(&stats);
+    return (long)stats.read_calls;
+}
+
+//이전 방식: 영역 끝에서부터 비어있지 않은 word를 찾을때까지 거꾸로 읽음
+static uint16 linear_fill_boundary(uint16 st_addr, uint16 end_addr)
+{
+    uint16 addr = end_addr + 1;
+    uint32 flash_val;
+
+    while (addr > st_addr) {
+        read_flash(addr - 1, FLOPT_UINT32, &flash_val);
+        if (flash_val != EMPTY_FLASH) {
+            break;
+        }
+        addr--;
+    }
+
+    return addr;
+}
+
+static void fill_area(uint16 st_addr, uint16 cnt)
+{
+    uint32 word = 0x12340000;
+    uint16 i;
+
+    HalFlashErase(ADDR_2_PAGE(st_addr));
+    for (i = 0; i < cnt; i++) {
+        word++;
+        write_flash(st_addr + i, &word);
+    }
+}
+
+static int measure(const char *name, uint16 st_addr, uint16 end_addr)
+{
+    uint16 size = end_addr - st_addr + 1;
+    uint16 fills[3] = {0, size / 2, size};
+    long lin, bin, lin_max = 0, bin_max = 0, t0;
+    uint16 cnt, b_lin, b_bin;
+    uint8 i;
+
+    for (cnt = 0; cnt <= size; cnt++) {
+        fill_area(st_addr, cnt);
+
+        t0 = read_calls();
+        b_lin = linear_fill_boundary(st_addr, end_addr);
+        lin = read_calls() - t0;
+
+        t0 = read_calls();
+        b_bin = search_fill_boundary(st_addr, end_addr);
+        bin = read_calls() - t0;
+
+        if (b_lin != b_bin || b_bin != st_addr + cnt) {
+            printf("FAIL %s fill %u: linear %04X binary %04X\n", name, cnt, b_lin, b_bin);
+            return 1;
+        }
+
+        lin_max = (lin > lin_max) ? lin : lin_max;
+        bin_max = (bin > bin_max) ? bin : bin_max;
+
+        for (i = 0; i < 3; i++) {
+            if (cnt == fills[i]) {
+                printf("%-16s %4u/%-4u %8ld %8ld\n", name, cnt, size, lin, bin);
+            }
+        }
+    }
+    printf("%-16s %9s %8ld %8ld\n", name, "worst", lin_max, bin_max);
+
+    return 0;
+}
+
+int main(void)
+{
+    int fail = 0;
+
+    sim_flash_reset();
+
+    printf("%-16s %9s %8s %8s\n", "area", "fill", "linear", "binary");
+    fail |= measure("settings record", FLADDR_SETTING_A + SETTING_REC_OFFSET,
+                    FLADDR_SETTING_A + PG_END_OFFSET);
+    fail |= measure("calib self", FLADDR_CALIB_SELF_ST, FLADDR_CALIB_SELF_ED);
+
+    return fail;
+}
@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+
+/* gen_trace - adc_noise 시험용 합성 배터리측 adc trace 생성
+ * 실제 측정 trace가 없어 아래 모델로 만든 것이며, 보드에서 같은 형식으로 받은 trace로 바꿀 수 있음.
+ *   adc = DC + 백색잡음(gaussian) + 충전기 switching ripple(sin), 변환 간격 132us(decimation 512)
+ * 형식: '#'로 시작하는 줄은 설명, 나머지는 한 줄에 14bit 변환값 하나.
+ *
+ * usage: gen_trace [개수] [DC(adc)] [잡음 sigma(LSB)] [ripple 진폭(LSB)] [ripple 주파수(Hz)] > trace */
+
+#define CONV_US     132
+#define PI2         6.283185307179586
+
+static uint32_t rnd_state = 19;
+
+static double uniform(void)
+{
+    rnd_state = rnd_state * 1103515245UL + 12345;
+    return (((rnd_state >> 8) & 0xFFFFFF) + 0.5) / 16777216.0;
+}
+
+static double gauss(void)
+{
+    return sqrt(-2 * log(uniform())) * cos(PI2 * uniform());
+}
+
+int main(int argc, char **argv)
+{
+    long cnt = (argc > 1) ? atol(argv[1]) : 8192;
+    double dc = (argc > 2) ? atof(argv[2]) : 6585.3;
+    double sigma = (argc > 3) ? atof(argv[3]) : 2.0;
+    double ripple = (argc > 4) ? atof(argv[4]) : 1.5;
+    double freq = (argc > 5) ? atof(argv[5]) : 1000;
+    long i, v;
+
+    printf("# synthetic battery side adc trace, generated by gen_trace.c (not a bench capture)\n");
+    printf("# dc %.1f, white sigma %.2f LSB, ripple %.2f LSB @ %.0f Hz, %d us/conversion, %ld samples\n",
+           dc, sigma, ripple, freq, CONV_US, cnt);
+    for (i = 0; i < cnt; i++) {
+        v = lround(dc + sigma * gauss() + ripple * sin(PI2 * freq * i * CONV_US * 1e-6));
+        printf("%ld\n", (v < 0) ? 0 : (v > 8191) ? 8191 : v);
+    }
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "host_sdk.h"
+#include <stdlib.h>
+
+/* host_test 공용 SDK 대체 구현
+ * SFR은 단순 변수, OSAL 메모리/타이머 함수는 libc 또는 빈 함수로 대체함.
+ * 타이머를 직접 돌려야 하는 시험은 해당 시험 파일에서 따로 구현함. */
+
+volatile uint8 P0, P0_0, P0_2, P0_3, P0_4, P0_5, P0_7;
+volatile uint8 P1_0, P1_1, P1_2, P1_3, P1_4, P1_5, P1_6, P2_0;
+volatile uint8 P0SEL, P0INP, P0DIR, P1SEL, P1INP, P1DIR, P2SEL, P2DIR, P2INP;
+volatile uint8 P0IE, P0IEN, P0IFG, P0IF, PICTL, IEN1;
+volatile uint8 ADCCON1, ADCCON2, ADCCON3, ADCL, ADCH, ADCIF, ADCIE, APCFG;
+volatile uint8 MEMCTR, DMAREQ, T1CTL;
+
+void *osal_mem_alloc(uint16 size)
+{
+    return malloc(size);
+}
+
+void osal_mem_free(void *ptr)
+{
+    free(ptr);
+}
+
+void *osal_memset(void *dst, uint8 value, int len)
+{
+    return memset(dst, value, len);
+}
+
+//OSAL과 같이 byte 단위로 복사, HalFlashRead와 같은 조건으로 읽기 속도를 비교하기 위함
+void *osal_memcpy(void *dst, const void *src, unsigned int len)
+{
+    uint8 *p_dst = (uint8 *)dst;
+    const uint8 *p_src = (const uint8 *)src;
+
+    while (len--) {
+        *p_dst++ = *p_src++;
+    }
+
+    return p_dst;
+}
+
+uint8 osal_memcmp(const void *src1, const void *src2, unsigned int len)
+{
+    return memcmp(src1, src2, len) == 0;
+}
+
+uint32 osal_GetSystemClock(void)
+{
+    return 0;
+}
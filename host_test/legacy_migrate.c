@@ -0,0 +1,193 @@
+#include "sim_flash.h"
+#include "sim_log.h"
+#include <stdio.h>
+
+/* legacy_migrate - 이전 펌웨어 플래시 레이아웃에서 처음 부팅하는 경우 시험
+ * 이전 고정주소 설정값, key log 페이지, 헤더 없는 2word 로그(data, time)로 채운 플래시에서
+ * settings_init의 모든 쓰기 word 위치에서 전원을 끊고 다시 부팅하여 다음을 확인함.
+ *  - 이전 설정값이 설정 페이지로 옮겨짐
+ *  - 로그 영역과 key log 페이지가 지워져 이전 로그가 로그페이지로 읽히지 않음
+ *    (첫 로그페이지의 2 ~ 4 word는 v5 헤더처럼 보이는 값으로 채움)
+ *  - migration 이후 기록한 로그가 다음 부팅에서 지워지지 않음
+ * 그리고 이전 레이아웃이 없는 플래시(erase_flash_log_area 이후)에서는 페이지의 wear word가 유지되는지 확인함. */
+
+#define LEGACY_CONN     CONN_USB_C
+#define LEGACY_CALIB    0x0ABC
+#define LEGACY_SELF     0x0AB7
+#define LEGACY_LOG_PGS  5
+#define LEGACY_KEYS     7
+
+static log_addr_t st_addrs[LOG_RING_CNT];
+
+static void write_word(uint16 addr, uint32 word)
+{
+    write_flash(addr, &word);
+}
+
+//이전 펌웨어가 남긴 플래시 상태
+static void legacy_fill(void)
+{
+    log_page_hdr_t fake;
+    flash_16bit_t key;
+    uint16 addr, i;
+
+    sim_flash_reset();
+
+    write_word(FLADDR_CONNTYPE, 0xFFFFFF00 | LEGACY_CONN);
+    key.high_16bit = 0x1000;
+    key.low_16bit = LEGACY_CALIB;
+    write_word(FLADDR_CALIB_REF, key.all_bits);
+    key.low_16bit = LEGACY_SELF - 1;
+    key.high_16bit = LEGACY_SELF;
+    write_word(FLADDR_CALIB_SELF_ST, key.all_bits);
+
+    //log data, time 2word 로그
+    for (addr = FLADDR_LOGDATA_ST; addr < FLADDR_LOGDATA_ST + LEGACY_LOG_PGS * (PG_END_OFFSET + 1); addr += 2) {
+        write_word(addr, 0x00123401 + ((uint32)addr << 8));
+        write_word(addr + 1, 0x00000100 + ((uint32)addr << 8));
+    }
+
+    //첫 로그페이지의 open/base time/close 위치를 v5 헤더로 보이는 값으로 덮어씀
+    HalFlashErase(ADDR_2_PAGE(FLADDR_LOGDATA_ST));
+    fake.open.data_all = EMPTY_FLASH;
+    fake.open.seq = 3;
+    fake.open.first_rec = LOG_PAGE_HDR_SIZE;
+    fake.open.state = PAGE_ST_OPEN;
+    fake.open.version = LOG_PAGE_VERSION;
+    write_word(FLADDR_LOGDATA_ST, 0x00123401);
+    write_word(FLADDR_LOGDATA_ST + 1, fake.open.data_all);
+    write_word(FLADDR_LOGDATA_ST + 2, 5000);
+    for (addr = FLADDR_LOGDATA_ST + 3; addr <= FLADDR_LOGDATA_ST + PG_END_OFFSET; addr++) {
+        write_word(addr, 0x00123401 + ((uint32)addr << 8));
+    }
+
+    //key log: tail 주소를 16bit씩 low_16bit부터 기록
+    for (i = 0; i < LEGACY_KEYS; i++) {
+        read_flash(FLADDR_SETTING_B + i / 2, FLOPT_UINT32, &key.all_bits);
+        if (i & 1) {
+            key.high_16bit = FLADDR_LOGDATA_ST + i * 40 + 1;
+        } else {
+            key.low_16bit = FLADDR_LOGDATA_ST + i * 40 + 1;
+        }
+        write_word(FLADDR_SETTING_B + i / 2, key.all_bits);
+    }
+}
+
+static void boot(void)
+{
+    log_data_t data;
+    uint8 r;
+
+    settings_init();
+    for (r = 0; r < LOG_RING_CNT; r++) {
+        log_system_init(&data, &st_addrs[r], r);
+    }
+}
+
+static int page_blank(uint8 pg)
+{
+    uint32 word;
+    uint16 addr;
+
+    for (addr = PAGE_2_ADDR(pg); addr <= PAGE_2_ADDR(pg) + PG_END_OFFSET; addr++) {
+        read_flash(addr, FLOPT_UINT32, &word);
+        if (word != EMPTY_FLASH) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//migration 이후 상태 확인, 실패 bit 반환
+static int check_migrated(void)
+{
+    uint16 val;
+    uint8 pg, r;
+    int bad = 0;
+
+    if (!settings_get(SET_KEY_CONN_TYPE, &val) || val != LEGACY_CONN ||
+        !settings_get(SET_KEY_CALIB_REF, &val) || val != LEGACY_CALIB ||
+        !settings_get(SET_KEY_CALIB_SELF, &val) || val != LEGACY_SELF) {
+        bad |= 1;
+    }
+
+    //로그 ring은 비어있어야 하고 로그 영역은 처음 기록 전까지 비어있음
+    for (r = 0; r < LOG_RING_CNT; r++) {
+        if (st_addrs[r].tail_addr || st_addrs[r].head_addr) {
+            bad |= 2;
+        }
+    }
+    for (pg = LOG_PAGE_ST; pg <= LOG_PAGE_ED; pg++) {
+        if (!page_blank(pg)) {
+            bad |= 4;
+            break;
+        }
+    }
+    return bad;
+}
+
+//migration 이후 기록한 로그가 다시 부팅해도 남아있는지 확인
+static int check_relog(void)
+{
+    uint16 head, tail;
+    uint32 now = 100;
+
+    sim_log_session(&st_addrs[LOG_RING_DISCHG], 1, 20, &now);
+    head = st_addrs[LOG_RING_DISCHG].head_addr;
+    tail = st_addrs[LOG_RING_DISCHG].tail_addr;
+
+    boot();
+    if (st_addrs[LOG_RING_DISCHG].tail_addr != tail ||
+        sim_log_verify(&st_addrs[LOG_RING_DISCHG], head, tail, 1, 20)) {
+        return 8;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    long k, runs = 0, fails = 0;
+    uint8 pg;
+    int bad, done = 0;
+
+    for (k = 0; !done; k++) {
+        legacy_fill();
+
+        sim_cut_at = sim_wr_words + k;
+        if (!setjmp(sim_pwr)) {
+            settings_init();
+            done = 1;
+        }
+        sim_cut_at = -1;
+
+        boot();
+        bad = check_migrated();
+        if (!bad) {
+            bad = check_relog();
+        }
+        if (sim_overwrite) {
+            bad |= 16;
+        }
+        runs++;
+        if (bad && ++fails < 10) {
+            printf("FAIL legacy cut %ld: %d\n", k, bad);
+        }
+    }
+
+    //이전 레이아웃이 없는 플래시, 지우기 횟수가 유지되어야 함
+    sim_flash_reset();
+    erase_flash_log_area();
+    boot();
+    for (pg = LOG_PAGE_ST; pg <= LOG_PAGE_ED; pg++) {
+        if (get_page_wear(pg) != 1) {
+            printf("FAIL blank layout: page %u wear %lu\n", pg, (unsigned long)get_page_wear(pg));
+            fails++;
+            break;
+        }
+    }
+    runs++;
+
+    printf("runs %ld fails %ld (settings writes cut at 0 ~ %ld)\n", runs, fails, k - 2);
+
+    return fails != 0;
+}
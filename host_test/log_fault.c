@@ -0,0 +1,171 @@
+#include "sim_flash.h"
+#include "sim_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* log_fault - 로그 세션 기록 중 전원 차단 시험
+ * 세션을 미리 채워둔 플래시에 세션 3개를 더 기록하면서 모든 쓰기 word 위치에서 전원을 끊고,
+ * 재부팅(복구) 도중에도 다시 전원이 끊기는 경우까지 포함하여 다음을 확인함.
+ *  - 마지막으로 commit이 끝난 세션이 그대로 읽힘 (데이터 손실 없음)
+ *  - 복구된 tail이 올바른 tail log를 가리킴
+ *  - 복구 후 이어서 기록한 세션도 정상이고, word 당 쓰기 횟수 제한을 넘지 않음
+ * 복구에 읽은 word 수의 최대/평균을 함께 출력함.
+ *
+ * usage: log_fault [미리 채울 세션 수 상한] */
+
+#define TEST_SESSIONS   3
+#define REBOOT_CUTS     3       //복구 중 전원 차단 위치 개수, 마지막 1번은 차단 없음
+
+typedef struct {
+    uint16 head;
+    uint16 tail;
+    uint16 sid;
+    uint8 cnt;
+} session_t;
+
+static log_addr_t st_addr;
+static session_t last_ok;
+static uint16 sid;
+static uint32 now;
+
+static void run_session(void)
+{
+    uint8 cnt = (uint8)(1 + sim_rand() % 40);
+
+    sim_log_session(&st_addr, sid, cnt, &now);
+
+    //전원 차단 없이 돌아왔다면 commit 완료
+    last_ok.head = st_addr.head_addr;
+    last_ok.tail = st_addr.tail_addr;
+    last_ok.sid = sid;
+    last_ok.cnt = cnt;
+
+    if (sim_rand() % 5 == 0) {
+        log_pre_erase(&st_addr);
+    }
+    sid++;
+}
+
+static void boot(void)
+{
+    log_data_t data;
+
+    settings_init();
+    log_system_init(&data, &st_addr, LOG_RING_DISCHG);
+}
+
+//seed와 warm 개수만으로 같은 플래시 상태를 다시 만듦
+static void prepare(uint16 warm)
+{
+    uint16 s;
+
+    sim_flash_reset();
+    sim_srand(warm);
+    sid = 0;
+    now = 100;
+    last_ok.tail = 0;
+
+    boot();
+    for (s = 0; s < warm; s++) {
+        run_session();
+    }
+}
+
+static int check_tail(void)
+{
+    log_word_t word;
+
+    if (!st_addr.tail_addr) {
+        return last_ok.tail ? 2 : 0;
+    }
+
+    read_flash(st_addr.tail_addr, FLOPT_UINT32, &word.data_all);
+    if (word.rec.log_type != TYPE_TAIL_LOG || word.rec.log_value != st_addr.head_addr) {
+        return 4;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint16 warm_max = (argc > 1) ? atoi(argv[1]) : 400;
+    flash_stats_t fs0, fs1;
+    session_t kept;
+    long writes, k, rd, read_max = 0, read_sum = 0, runs = 0, fails = 0;
+    uint16 warm;
+    uint8 s, j;
+    int bad;
+
+    for (warm = 0; warm < warm_max; warm += 7) {
+        //시험 구간의 쓰기 word 수 측정
+        prepare(warm);
+        writes = sim_wr_words;
+        for (s = 0; s < TEST_SESSIONS; s++) {
+            run_session();
+        }
+        writes = sim_wr_words - writes;
+
+        for (k = 0; k < writes; k++) {
+            for (j = 0; j <= REBOOT_CUTS; j++) {
+                prepare(warm);
+
+                sim_cut_at = sim_wr_words + k;
+                if (!setjmp(sim_pwr)) {
+                    for (s = 0; s < TEST_SESSIONS; s++) {
+                        run_session();
+                    }
+                }
+                sim_cut_at = -1;
+
+                //복구 중 j번째 쓰기에서 다시 전원 차단
+                if (j < REBOOT_CUTS) {
+                    sim_cut_at = sim_wr_words + j;
+                    if (!setjmp(sim_pwr)) {
+                        boot();
+                    }
+                    sim_cut_at = -1;
+                }
+
+                get_flash_stats(&fs0);
+                boot();
+                get_flash_stats(&fs1);
+                rd = fs1.read_words - fs0.read_words;
+                read_sum += rd;
+                read_max = (rd > read_max) ? rd : read_max;
+                runs++;
+
+                bad = 0;
+                if (last_ok.tail &&
+                    sim_log_verify(&st_addr, last_ok.head, last_ok.tail, last_ok.sid, last_ok.cnt)) {
+                    bad |= 1;
+                }
+                bad |= check_tail();
+
+                //복구 후 이어서 기록, 이전 세션과 새 세션 모두 읽혀야 함
+                kept = last_ok;
+                now = 5;
+                for (s = 0; s < TEST_SESSIONS; s++) {
+                    run_session();
+                }
+                if ((kept.tail && sim_log_verify(&st_addr, kept.head, kept.tail, kept.sid, kept.cnt)) ||
+                    sim_log_verify(&st_addr, last_ok.head, last_ok.tail, last_ok.sid, last_ok.cnt)) {
+                    bad |= 8;
+                }
+                if (sim_overwrite) {
+                    bad |= 16;
+                }
+
+                if (bad) {
+                    if (++fails < 10) {
+                        printf("FAIL warm %u cut %ld reboot cut %u: %d\n", warm, k, j, bad);
+                    }
+                }
+            }
+        }
+    }
+
+    printf("runs %ld fails %ld, recovery read words max %ld avg %ld\n",
+           runs, fails, read_max, runs ? read_sum / runs : 0);
+
+    return fails != 0;
+}
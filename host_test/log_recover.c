@@ -0,0 +1,101 @@
+#include "sim_flash.h"
+#include "sim_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* log_recover - 부팅시 로그 주소 복구(log_system_init)의 플래시 읽기 횟수 측정
+ * 세 ring에 세션을 계속 기록하면서 매 세션마다 재부팅을 흉내내어 복구하고
+ * 복구된 head/tail이 기록중이던 값과 같은지, 복구에 읽은 횟수/word 수가 최대 얼마인지 출력함.
+ * ring이 한바퀴 이상 돌아 모든 페이지가 찬 상태까지 포함됨.
+ *
+ * usage: log_recover [세션 수] */
+
+typedef struct {
+    long calls;
+    long words;
+} read_cost_t;
+
+static log_addr_t rings[LOG_RING_CNT];
+
+static read_cost_t boot_recover(log_addr_t *apst_out)
+{
+    flash_stats_t before, after;
+    log_data_t data;
+    read_cost_t cost;
+    uint8 r;
+
+    get_flash_stats(&before);
+    for (r = 0; r < LOG_RING_CNT; r++) {
+        log_system_init(&data, &apst_out[r], r);
+    }
+    get_flash_stats(&after);
+
+    cost.calls = after.read_calls - before.read_calls;
+    cost.words = after.read_words - before.read_words;
+    return cost;
+}
+
+static void keep_max(read_cost_t *apst_max, read_cost_t cost)
+{
+    if (cost.calls > apst_max->calls) {
+        apst_max->calls = cost.calls;
+    }
+    if (cost.words > apst_max->words) {
+        apst_max->words = cost.words;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long sessions = (argc > 1) ? atol(argv[1]) : 6000;
+    log_addr_t booted[LOG_RING_CNT];
+    read_cost_t cost, max_fill = {0, 0}, max_wrap = {0, 0};
+    uint32 now = 100;
+    uint8 wrapped = FALSE;
+    long s;
+    uint8 r;
+
+    sim_flash_reset();
+    sim_srand(1);
+    settings_init();
+
+    cost = boot_recover(rings);
+    printf("log pages %d (chg %d, dischg %d, evt %d), %d words/page\n",
+           LOG_PAGE_CNT, LOG_RING_CHG_PAGES, LOG_RING_DISCHG_PAGES, LOG_RING_EVT_PAGES,
+           HAL_FLASH_PAGE_SIZE / HAL_FLASH_WORD_SIZE);
+    printf("%-22s %8s %8s\n", "flash state", "calls", "words");
+    printf("%-22s %8ld %8ld\n", "erased", cost.calls, cost.words);
+
+    for (s = 0; s < sessions; s++) {
+        //충전 ring에 가장 많이, 이벤트 ring에는 가끔씩 기록
+        r = (s % 8 == 7) ? LOG_RING_EVT : (s % 3 == 0) ? LOG_RING_DISCHG : LOG_RING_CHG;
+        sim_log_session(&rings[r], (uint16)s, (uint8)(1 + sim_rand() % 40), &now);
+
+        cost = boot_recover(booted);
+        for (r = 0; r < LOG_RING_CNT; r++) {
+            if (booted[r].head_addr != rings[r].head_addr ||
+                booted[r].tail_addr != rings[r].tail_addr) {
+                printf("FAIL session %ld ring %d: head %04X/%04X tail %04X/%04X\n", s, r,
+                       booted[r].head_addr, rings[r].head_addr,
+                       booted[r].tail_addr, rings[r].tail_addr);
+                return 1;
+            }
+            rings[r] = booted[r];
+        }
+
+        if (!wrapped && rings[LOG_RING_DISCHG].page_seq > LOG_RING_DISCHG_PAGES &&
+            rings[LOG_RING_CHG].page_seq > LOG_RING_CHG_PAGES &&
+            rings[LOG_RING_EVT].page_seq > LOG_RING_EVT_PAGES) {
+            wrapped = TRUE;
+        }
+        keep_max(wrapped ? &max_wrap : &max_fill, cost);
+    }
+
+    printf("%-22s %8ld %8ld\n", "filling (worst)", max_fill.calls, max_fill.words);
+    printf("%-22s %8ld %8ld\n", "all rings wrapped", max_wrap.calls, max_wrap.words);
+    printf("%ld sessions, page seq chg %u dischg %u evt %u, overwrite %d\n", sessions,
+           rings[LOG_RING_CHG].page_seq, rings[LOG_RING_DISCHG].page_seq,
+           rings[LOG_RING_EVT].page_seq, sim_overwrite);
+
+    return (wrapped && !sim_overwrite) ? 0 : 1;
+}
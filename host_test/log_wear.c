@@ -0,0 +1,235 @@
+#include "sim_flash.h"
+#include "sim_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* log_wear - ring별 로그페이지 지우기 횟수 측정
+ * main_task의 로그 기록 경로(set_log_data, save_charging_log, cable_check_done,
+ * stop_charging/stop_discharging의 세션 종료, 대기중 log_pre_erase)를 그대로 흉내내어
+ * 사용 profile별로 SIM_DAYS일 동안 기록하고 ring별 페이지당 지우기 횟수를 비교함.
+ *   nominal: 하루 대여 RENTALS회, 반납마다 CHG_MIN분 충전(10초 샘플), 충전 중 분리 1회/일
+ *   ext-loss: nominal + 키오스크 전원 불안정으로 충전 중 외부전압 끊김 LOSS_HEAVY회/일
+ * 각 ring의 페이지당 지우기 횟수가 로그 영역 전체 평균의 WEAR_RATIO_MAX배를 넘으면 실패.
+ * 그리고 각 로그페이지를 지운 직후 wear word 기록 도중 전원을 끊어 ring 상의 이웃 페이지로
+ * 다시 만든 횟수와 실제 횟수의 차이를 구함. ring 안쪽 페이지와 경계 페이지 모두 1 이하여야 함.
+ *
+ * usage: log_wear [일 수] */
+
+#define SIM_DAYS        365
+#define RENTALS         4
+#define CHG_MIN         90
+#define LOSS_HEAVY      30
+#define WEAR_RATIO_MAX  1.5
+
+typedef struct {
+    const char *name;
+    uint16 losses;      //충전 중 외부전압 끊김 횟수/일
+} profile_t;
+
+static log_addr_t rings[LOG_RING_CNT];
+static log_aggr_t aggr;
+static Control_flag_t flags;
+static uint32 now;
+
+static void time_of(time_data_t *apst_times)
+{
+    apst_times->log_evt = LOG_HEAD_TIME;
+    apst_times->time_value = now;
+}
+
+//set_log_data와 같은 경로, 이상 이벤트는 이벤트 ring에 세션으로, 방전 ring에는 RAM 버퍼로
+static void log_event(uint16 status, uint16 value)
+{
+    log_data_t data;
+    time_data_t times;
+    uint8 r;
+
+    data.data_all = 0;
+    data.log_evt = (uint8)status;
+    data.log_value = value;
+    data.log_type = TYPE_NORMAL_LOG;
+    time_of(&times);
+
+    if (status & LOG_EVT_ABNORMAL) {
+        log_event_store(&rings[LOG_RING_EVT], &data, &times);
+    }
+    log_stage_push(&rings[LOG_RING_DISCHG], &data, &times);
+    if (status & LOG_EVT_CRITICAL) {
+        for (r = 0; r < LOG_RING_CNT; r++) {
+            log_stage_flush(&rings[r], LOG_STAGE_SIZE);
+        }
+    }
+}
+
+static void close_session(uint8 ring)
+{
+    time_data_t times;
+
+    time_of(&times);
+    log_session_close(&rings[ring], flags, &times);
+}
+
+//대기중 EVT_LOG_FLUSH 이후의 미리 지우기
+static void idle(uint32 sec)
+{
+    uint8 r;
+
+    for (r = 0; r < LOG_RING_CNT; r++) {
+        log_stage_flush(&rings[r], LOG_STAGE_SIZE);
+        while (log_pre_erase(&rings[r]));
+    }
+    now += sec;
+}
+
+//충전 1회, cut_sec초에 외부전압이 끊기면(0: 끊기지 않음) 이벤트를 남기고 중단
+static void charge(uint32 cut_sec)
+{
+    int16 samples[LOG_AGGR_CH_CNT];
+    uint32 t, dur = CHG_MIN * 60;
+
+    log_raw_push(&rings[LOG_RING_CHG], LOG_ITEM_PMIC, (int16)(40 + sim_rand() % 20), now);
+    for (t = 0; t < dur; t += 10) {
+        //CC 구간 후 마지막 1/3은 CV 구간에서 전류 감소
+        samples[LOG_ITEM_VOLT - 1] = (int16)(3600 + 600 * t / dur);
+        samples[LOG_ITEM_CURR - 1] = (int16)((t < dur * 2 / 3) ? 2000 : 2000 - 1700 * (t - dur * 2 / 3) / (dur / 3));
+        samples[LOG_ITEM_TEMP - 1] = (int16)(250 + 100 * t / dur + sim_rand() % 5);
+        samples[LOG_ITEM_CURR - 1] += (int16)(sim_rand() % 41) - 20;
+        log_aggr_sample(&rings[LOG_RING_CHG], &aggr, samples, now);
+        now += 10;
+
+        if (cut_sec && t >= cut_sec) {
+            log_aggr_flush(&rings[LOG_RING_CHG], &aggr, now);
+            close_session(LOG_RING_CHG);
+            log_event(LOG_EVT_EXT_V_LOSS, 0);
+            return;
+        }
+    }
+    log_aggr_flush(&rings[LOG_RING_CHG], &aggr, now);
+    close_session(LOG_RING_CHG);
+}
+
+static void run_day(const profile_t *apst_pf)
+{
+    uint32 day_end = now + 86400;
+    uint16 i;
+
+    for (i = 0; i < RENTALS; i++) {
+        //대여 후 반납, 방전 세션 종료
+        idle(3 * 3600);
+        close_session(LOG_RING_DISCHG);
+        charge((i == 0) ? CHG_MIN * 30 : 0);
+    }
+    for (i = 0; i < apst_pf->losses; i++) {
+        charge(60 + sim_rand() % 600);
+        idle(60);
+    }
+    if (now < day_end) {
+        idle(day_end - now);
+    }
+}
+
+//ring 상의 앞/뒤 페이지, log_mgr의 prev_log_page/next_log_page와 같음
+static uint8 ring_prev(uint8 r, uint8 pg)
+{
+    return (pg == rings[r].pg_st) ? rings[r].pg_ed : pg - 1;
+}
+
+static uint8 ring_next(uint8 r, uint8 pg)
+{
+    return (pg == rings[r].pg_ed) ? rings[r].pg_st : pg + 1;
+}
+
+//각 로그페이지 지우기를 wear word 기록 도중 끊고 추정된 횟수와 실제 횟수의 최대 차이 (ring 안쪽 페이지)
+static long wear_cut_error(long *p_edge)
+{
+    static uint8 saved[HAL_FLASH_PAGE_SIZE];
+    long err, max_err = 0;
+    uint32 old_cnt;
+    uint8 pg, r, edge;
+
+    *p_edge = 0;
+    for (r = 0; r < LOG_RING_CNT; r++) {
+        for (pg = rings[r].pg_st; pg <= rings[r].pg_ed; pg++) {
+            old_cnt = get_page_wear_near(pg, ring_prev(r, pg), ring_next(r, pg));
+            memcpy(saved, sim_flash[pg], HAL_FLASH_PAGE_SIZE);
+
+            sim_cut_at = sim_wr_words;
+            if (!setjmp(sim_pwr)) {
+                flash_page_erase_near(pg, ring_prev(r, pg), ring_next(r, pg));
+            }
+            sim_cut_at = -1;
+
+            err = (long)get_page_wear_near(pg, ring_prev(r, pg), ring_next(r, pg)) - (long)old_cnt;
+            err = (err < 0) ? -err : err;
+            edge = (pg == rings[r].pg_st || pg == rings[r].pg_ed);
+            if (edge) {
+                *p_edge = (err > *p_edge) ? err : *p_edge;
+            } else {
+                max_err = (err > max_err) ? err : max_err;
+            }
+            memcpy(sim_flash[pg], saved, HAL_FLASH_PAGE_SIZE);
+        }
+    }
+
+    return max_err;
+}
+
+int main(int argc, char **argv)
+{
+    static const profile_t profiles[] = {{"nominal", 0}, {"ext-loss", LOSS_HEAVY}};
+    long days = (argc > 1) ? atol(argv[1]) : SIM_DAYS;
+    uint32 sum[LOG_RING_CNT], max[LOG_RING_CNT], total, wear;
+    double mean, ratio;
+    log_data_t data;
+    uint8 p, r, pg;
+    long d, cut_err, edge_err;
+    int fail = 0;
+
+    printf("%-9s %-7s %5s %9s %9s %8s\n", "profile", "ring", "pages", "erase/pg", "max", "vs mean");
+    for (p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+        sim_flash_reset();
+        sim_srand(3);
+        settings_init();
+        for (r = 0; r < LOG_RING_CNT; r++) {
+            log_system_init(&data, &rings[r], r);
+        }
+        log_aggr_init(&aggr, LOG_AGGR_WINDOW);
+        memset(&flags, 0, sizeof(flags));
+        flags.serv_en = 1;
+        now = 100;
+
+        for (d = 0; d < days; d++) {
+            run_day(&profiles[p]);
+        }
+
+        total = 0;
+        for (r = 0; r < LOG_RING_CNT; r++) {
+            sum[r] = 0;
+            max[r] = 0;
+            for (pg = rings[r].pg_st; pg <= rings[r].pg_ed; pg++) {
+                wear = get_page_wear_near(pg, ring_prev(r, pg), ring_next(r, pg));
+                sum[r] += wear;
+                max[r] = (wear > max[r]) ? wear : max[r];
+            }
+            total += sum[r];
+        }
+
+        mean = (double)total / LOG_PAGE_CNT;
+        for (r = 0; r < LOG_RING_CNT; r++) {
+            ratio = (double)sum[r] / (rings[r].pg_ed - rings[r].pg_st + 1) / mean;
+            printf("%-9s %-7u %5u %9.1f %9lu %8.2f\n", profiles[p].name, r, rings[r].pg_ed - rings[r].pg_st + 1,
+                   (double)sum[r] / (rings[r].pg_ed - rings[r].pg_st + 1), (unsigned long)max[r], ratio);
+            if (ratio > WEAR_RATIO_MAX) {
+                fail = 1;
+            }
+        }
+
+        cut_err = wear_cut_error(&edge_err);
+        printf("%-9s erase cut: wear error %ld (ring edge pages %ld)\n", profiles[p].name, cut_err, edge_err);
+        if (cut_err > 1 || edge_err > 1) {
+            fail = 1;
+        }
+    }
+
+    return fail;
+}
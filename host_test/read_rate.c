@@ -0,0 +1,131 @@
+#include "sim_flash.h"
+#include "sim_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* read_rate - 플래시 읽기 속도 비교 (word/sec)
+ * 이전 read_flash(word마다 HalFlashRead 호출)와 read_flash_bulk(bank를 한번 매핑하여 연속 복사)로
+ * 로그 영역 전체를 읽는 속도, 그리고 로그 전송 경로(log_query)의 읽기 속도를 측정함.
+ * host에서의 절대 속도는 8051과 다르므로 비율과 word당 읽기 호출(bank 매핑) 횟수를 함께 봐야 함.
+ *
+ * usage: read_rate [반복 횟수] */
+
+static volatile uint32 sink;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//이전 read_flash, word마다 HalFlashRead로 4byte를 읽어 형변환 복사
+static void legacy_read_flash(uint16 ai_addr, eFlash_Var_t value_type, void *p_value)
+{
+    uint8 tmp[4];
+
+    HalFlashRead(ADDR_2_PAGE(ai_addr), ADDR_2_RECORD(ai_addr) * 4, tmp, HAL_FLASH_WORD_SIZE);
+    switch(value_type) {
+        case FLOPT_UINT8:
+            *((uint8*)p_value) = *(uint8*)tmp;
+            break;
+        case FLOPT_UINT16:
+            *((uint16*)p_value) = *(uint16*)tmp;
+            break;
+        case FLOPT_UINT32:
+            *((uint32 *)p_value) = *(uint32*)tmp;
+            break;
+        case FLOPT_FLOAT:
+            *((float *)p_value) = *(float*)tmp;
+            break;
+    }
+}
+
+static void report(const char *name, long words, double sec, long maps)
+{
+    printf("%-26s %12.0f %11.3f\n", name, words / sec, (double)maps / words);
+}
+
+int main(int argc, char **argv)
+{
+    int reps = (argc > 1) ? atoi(argv[1]) : 200;
+    uint16 st = FLADDR_LOGDATA_ST;
+    uint16 words = FLADDR_LOGDATA_ED - FLADDR_LOGDATA_ST + 1;
+    uint32 buf[HAL_FLASH_PAGE_SIZE / HAL_FLASH_WORD_SIZE];
+    static const uint16 bulk_cnt[2] = {LOG_READ_WIN, HAL_FLASH_PAGE_SIZE / HAL_FLASH_WORD_SIZE};
+    flash_stats_t fs0, fs1;
+    log_addr_t addr;
+    log_data_t data;
+    time_data_t times;
+    uint32 now = 100, v;
+    uint16 a, sid;
+    long total, records;
+    double t0;
+    int r;
+    uint8 i;
+
+    sim_flash_reset();
+    sim_srand(3);
+    settings_init();
+    log_system_init(&data, &addr, LOG_RING_DISCHG);
+    for (sid = 0; addr.page_seq <= LOG_RING_DISCHG_PAGES; sid++) {
+        sim_log_session(&addr, sid, (uint8)(1 + sim_rand() % 40), &now);
+    }
+
+    printf("log area %u words, %d reps\n", words, reps);
+    printf("%-26s %12s %11s\n", "path", "words/sec", "calls/word");
+
+    //before: word 단위 read_flash
+    total = 0;
+    sim_hal_reads = 0;
+    t0 = now_sec();
+    for (r = 0; r < reps; r++) {
+        for (a = 0; a < words; a++) {
+            legacy_read_flash(st + a, FLOPT_UINT32, &v);
+            sink += v;
+        }
+        total += words;
+    }
+    report("read_flash (per word)", total, now_sec() - t0, sim_hal_reads);
+
+    //after: read_flash_bulk, 로그 읽기 window 크기와 페이지 크기
+    for (i = 0; i < 2; i++) {
+        char name[32];
+
+        total = 0;
+        get_flash_stats(&fs0);
+        t0 = now_sec();
+        for (r = 0; r < reps; r++) {
+            for (a = 0; a < words; a += bulk_cnt[i]) {
+                read_flash_bulk(st + a, buf, bulk_cnt[i]);
+                sink += buf[0];
+            }
+            total += words;
+        }
+        get_flash_stats(&fs1);
+        snprintf(name, sizeof(name), "read_flash_bulk (%u word)", bulk_cnt[i]);
+        report(name, total, now_sec() - t0, fs1.read_calls - fs0.read_calls);
+    }
+
+    //로그 전송 경로: 로그 검색(log_query)으로 ring 전체를 오래된 순서로 읽음
+    records = 0;
+    get_flash_stats(&fs0);
+    t0 = now_sec();
+    for (r = 0; r < reps; r++) {
+        log_query_t qry;
+
+        log_query_begin(&qry, LOG_QRY_ALL, 0, 0xFFFFFFFF);
+        while (!log_query(&addr, &qry, &data, &times)) {
+            records++;
+        }
+    }
+    t0 = now_sec() - t0;
+    get_flash_stats(&fs1);
+    total = fs1.read_words - fs0.read_words;
+    report("log_query (transmit)", total, t0, fs1.read_calls - fs0.read_calls);
+    printf("%-26s %12.0f records/sec\n", "", records / t0);
+
+    return 0;
+}
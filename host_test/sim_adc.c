@@ -0,0 +1,78 @@
+#include "sim_adc.h"
+
+uint32 sim_adc_now;
+uint32 sim_adc_io_time;
+long sim_adc_convs;
+
+static uint8 io_last;
+
+void adc_sampler_isr(void);
+
+void sim_adc_reset(void)
+{
+    sim_adc_now = 0;
+    sim_adc_io_time = 0;
+    sim_adc_convs = 0;
+    io_last = 0;
+}
+
+//IO 변경은 다음 변환이나 대기 시작 시점에 확인, 그 사이에는 시간이 흐르지 않음
+static void io_check(void)
+{
+    uint8 io = (IO_ADC_BATT_SIDE ? 1 : 0) | (IO_ADC_INDUCTOR_SIDE ? 2 : 0);
+
+    if (io != io_last) {
+        io_last = io;
+        sim_adc_io_time = sim_adc_now;
+    }
+}
+
+static uint16 convert(uint8 channel, uint16 conv_us)
+{
+    uint16 adc_val;
+
+    io_check();
+    adc_val = sim_adc_sample(channel, conv_us);
+    sim_adc_now += conv_us;
+    sim_adc_convs++;
+
+    return adc_val;
+}
+
+uint16 HalAdcRead(uint8 channel, uint8 resolution)
+{
+    return convert(channel, SIM_ADC_DEC512_US);
+}
+
+void HalAdcSetReference(uint8 reference)
+{
+}
+
+void delay_us(uint16 microSecs)
+{
+    io_check();
+    sim_adc_now += microSecs;
+}
+
+/**
+ * @fn sim_adc_tick
+ * @brief adc_sampler_tick으로 한 주기를 시작하고, ADCCON3 기록으로 시작된 변환을
+ *        완료 인터럽트(adc_sampler_isr)까지 이어서 주기가 끝날때까지 진행
+ */
+void sim_adc_tick(void)
+{
+    uint16 raw;
+    uint8 dec;
+
+    adc_sampler_tick();
+    while (ADCIE && (ADCCON3 & 0x30)) {
+        dec = ADCCON3 & 0x30;
+        //결과는 상위 14bit에 정렬됨
+        raw = convert(ADCCON3 & 0x0F, (dec == ADC_SAMP_DEC_512) ? SIM_ADC_DEC512_US : SIM_ADC_DEC256_US) << 2;
+        ADCL = (uint8)raw;
+        ADCH = (uint8)(raw >> 8);
+        ADCCON3 = 0;
+        ADCIF = 1;
+        adc_sampler_isr();
+    }
+}
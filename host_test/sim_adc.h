@@ -0,0 +1,28 @@
+#ifndef __SIM_ADC__
+#define __SIM_ADC__
+
+#include "adc_interface.h"
+
+/* sim_adc - ADC 변환 시간과 sampler 인터럽트 흐름 에뮬레이션
+ * blocking 변환(HalAdcRead)과 인터럽트 변환(adc_sampler_isr) 모두 시험 파일의 sim_adc_sample로 값을 얻고,
+ * 변환 시간만큼 sim_adc_now가 진행됨. delay_us도 시간을 진행시킴.
+ * shunt 측 IO(IO_ADC_BATT_SIDE/IO_ADC_INDUCTOR_SIDE)가 바뀐 시각을 기록하여 안정화 시간을 확인할 수 있음. */
+
+#define SIM_ADC_DEC512_US   132     //decimation 512 변환 시간(HAL_ADC_RESOLUTION_14)
+#define SIM_ADC_DEC256_US   68
+
+extern uint32 sim_adc_now;      //시각(us)
+extern uint32 sim_adc_io_time;  //shunt IO가 마지막으로 바뀐 시각(us)
+extern long sim_adc_convs;      //변환 횟수
+
+/**
+ * @fn sim_adc_sample
+ * @brief 시험 파일에서 구현, 변환 결과(0 ~ ADC_FULL_SCALE)를 반환
+ *        호출 시점의 sim_adc_now는 변환 시작 시각, IO 상태는 IO_ADC_* 로 확인
+ */
+uint16 sim_adc_sample(uint8 channel, uint16 conv_us);
+
+void sim_adc_reset(void);
+void sim_adc_tick(void);
+
+#endif
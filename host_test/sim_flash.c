@@ -0,0 +1,83 @@
+#include "sim_flash.h"
+#include <stdlib.h>
+
+uint8 sim_flash[SIM_FLASH_PAGES][HAL_FLASH_PAGE_SIZE];
+
+long sim_hal_reads;
+long sim_wr_words;
+long sim_cut_at = -1;
+int sim_overwrite;
+jmp_buf sim_pwr;
+
+//word별 쓰기 횟수, 지우면 0
+static uint8 wr_cnt[SIM_FLASH_PAGES * HAL_FLASH_PAGE_SIZE / HAL_FLASH_WORD_SIZE];
+
+void sim_flash_reset(void)
+{
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+    memset(wr_cnt, 0, sizeof(wr_cnt));
+    sim_hal_reads = 0;
+    sim_wr_words = 0;
+    sim_cut_at = -1;
+    sim_overwrite = 0;
+}
+
+//SDK hal_flash.c와 같은 방식, 호출마다 bank를 XDATA에 매핑하고 byte 단위로 복사
+void HalFlashRead(uint8 pg, uint16 offset, uint8 *buf, uint16 cnt)
+{
+    halIntState_t is;
+    uint8 memctr = MEMCTR;
+    uint8 *p_data;
+
+    sim_hal_reads++;
+
+    HAL_ENTER_CRITICAL_SECTION(is);
+    MEMCTR = (MEMCTR & 0xF8) | (pg / HAL_FLASH_PAGE_PER_BANK);
+    //host에서는 매핑 창의 위치가 MEMCTR에 따라 바뀌므로 bank 선택 후 계산
+    p_data = (uint8 *)(offset + HAL_FLASH_PAGE_MAP) + ((pg % HAL_FLASH_PAGE_PER_BANK) * HAL_FLASH_PAGE_SIZE);
+    while (cnt--) {
+        *buf++ = *p_data++;
+    }
+    MEMCTR = memctr;
+    HAL_EXIT_CRITICAL_SECTION(is);
+}
+
+void HalFlashWrite(uint16 addr, uint8 *buf, uint16 cnt)
+{
+    uint8 *dst;
+    uint8 old[HAL_FLASH_WORD_SIZE];
+    uint16 w;
+    uint8 i;
+
+    for (w = 0; w < cnt; w++) {
+        dst = &((uint8 *)sim_flash)[(uint32)(addr + w) * HAL_FLASH_WORD_SIZE];
+
+        if (sim_wr_words == sim_cut_at) {
+            //기록 도중 전원 차단, 일부 bit만 0으로 바뀐 word를 남김
+            //바뀐 bit가 없으면 기록을 시작하지 않은 것과 구분할 수 없으므로 쓰기 횟수에 넣지 않음
+            memcpy(old, dst, HAL_FLASH_WORD_SIZE);
+            for (i = 0; i < HAL_FLASH_WORD_SIZE; i++) {
+                dst[i] &= buf[w * HAL_FLASH_WORD_SIZE + i] | (uint8)rand();
+            }
+            if (memcmp(old, dst, HAL_FLASH_WORD_SIZE) && ++wr_cnt[addr + w] > 2) {
+                sim_overwrite++;
+            }
+            longjmp(sim_pwr, 1);
+        }
+
+        if (++wr_cnt[addr + w] > 2) {
+            sim_overwrite++;
+        }
+        for (i = 0; i < HAL_FLASH_WORD_SIZE; i++) {
+            dst[i] &= buf[w * HAL_FLASH_WORD_SIZE + i];
+        }
+        sim_wr_words++;
+    }
+}
+
+void HalFlashErase(uint8 pg)
+{
+    memset(sim_flash[pg], 0xFF, HAL_FLASH_PAGE_SIZE);
+    memset(&wr_cnt[pg * (HAL_FLASH_PAGE_SIZE / HAL_FLASH_WORD_SIZE)], 0,
+           HAL_FLASH_PAGE_SIZE / HAL_FLASH_WORD_SIZE);
+}
@@ -0,0 +1,21 @@
+#ifndef __SIM_FLASH__
+#define __SIM_FLASH__
+
+#include "host_sdk.h"
+#include <setjmp.h>
+
+/* sim_flash - CC254x 내부 플래시 RAM 에뮬레이션
+ * 쓰기는 실제 플래시처럼 bit를 1->0으로만 바꾸고(AND), 지우기는 페이지 단위로 0xFF로 채움.
+ * 같은 word를 2번 넘게 쓰면 sim_overwrite를 증가시킴. (CC254x word 당 쓰기 횟수 제한)
+ * sim_cut_at에 word 번호를 주면 해당 번째 word 쓰기 도중 전원이 끊긴 것처럼
+ * 일부 bit만 기록하고 sim_pwr로 longjmp함. (바뀐 bit가 없다면 쓰기 횟수에 넣지 않음) */
+
+extern long sim_hal_reads;      //HalFlashRead 호출 횟수
+extern long sim_wr_words;       //sim_flash_reset 이후 기록한 word 수
+extern long sim_cut_at;         //전원 차단할 쓰기 word 번호, -1: 차단 없음
+extern int sim_overwrite;
+extern jmp_buf sim_pwr;
+
+void sim_flash_reset(void);
+
+#endif
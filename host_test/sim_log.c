@@ -0,0 +1,95 @@
+#include "sim_log.h"
+
+static uint32 rnd_state = 1;
+
+void sim_srand(uint32 seed)
+{
+    rnd_state = seed;
+}
+
+//플랫폼과 무관하게 같은 순서를 내는 LCG
+uint16 sim_rand(void)
+{
+    rnd_state = rnd_state * 1103515245UL + 12345;
+    return (uint16)((rnd_state >> 16) & 0x7FFF);
+}
+
+/**
+ * @fn sim_log_session
+ * @brief 로그 cnt개를 staging 경로로 기록하고 세션을 닫음(commit)
+ *        방전 로그처럼 가끔씩 staging buffer를 비우며, 시각은 0~29초 또는 200초씩 증가함.
+ * 
+ * @param apst_addr: 로그 주소
+ * @param sid: 세션 번호, 로그 값 검증용
+ * @param cnt: 세션의 로그 개수
+ * @param p_time: 현재 시각(sec), 마지막 로그 시각으로 갱신됨
+ */
+void sim_log_session(log_addr_t *apst_addr, uint16 sid, uint8 cnt, uint32 *p_time)
+{
+    log_data_t data;
+    time_data_t times;
+    Control_flag_t flags;
+    uint8 i;
+
+    for (i = 0; i < cnt; i++) {
+        data.data_all = 0;
+        data.log_evt = 1;
+        data.log_value = ((sid & 0xFF) << 8) | i;
+        data.log_type = TYPE_NORMAL_LOG;
+
+        *p_time += (sim_rand() % 5 == 0) ? 200 : sim_rand() % 30;
+        times.log_evt = LOG_HEAD_TIME;
+        times.time_value = *p_time;
+        log_stage_push(apst_addr, &data, &times);
+
+        if (sim_rand() % 7 == 0) {
+            log_stage_flush(apst_addr, 8);
+        }
+    }
+
+    memset(&flags, 0, sizeof(flags));
+    flags.serv_en = 1;
+    *p_time += 3;
+    times.time_value = *p_time;
+    log_stage_flush(apst_addr, LOG_STAGE_SIZE);
+    wrtie_tail_log(apst_addr, flags, &times);
+}
+
+/**
+ * @fn sim_log_verify
+ * @brief head ~ tail 구간을 읽어 sim_log_session이 기록한 세션과 같은지 확인
+ * 
+ * @return 0: 일치, -1: 읽기 실패, -2: tail log 이상 또는 개수 불일치, -3: 로그 값 불일치
+ */
+int sim_log_verify(log_addr_t *apst_addr, uint16 head, uint16 tail, uint16 sid, uint8 cnt)
+{
+    log_addr_t addr = *apst_addr;
+    log_data_t data;
+    time_data_t times;
+    uint16 at;
+    uint8 k = 0;
+
+    addr.head_addr = head;
+    addr.tail_addr = tail;
+    log_read_begin(&addr);
+
+    while (1) {
+        at = addr.offset_addr;
+        if (log_read_record(&addr, &data, &times)) {
+            return -1;
+        }
+
+        if (at == tail) {
+            return (data.log_type == TYPE_TAIL_LOG && k == cnt) ? 0 : -2;
+        }
+
+        if (data.log_type == TYPE_EXT_LOG) {
+            continue;
+        }
+
+        if ((data.log_value & 0xFF) != k || (data.log_value >> 8) != (sid & 0xFF)) {
+            return -3;
+        }
+        k++;
+    }
+}
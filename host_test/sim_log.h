@@ -0,0 +1,16 @@
+#ifndef __SIM_LOG__
+#define __SIM_LOG__
+
+#include "log_mgr.h"
+
+/* sim_log - host 시험용 로그 세션 생성/검증
+ * 세션의 각 로그는 log_value = (세션번호 & 0xFF) << 8 | 로그번호 로 기록되어
+ * 읽어들인 값만으로 빠진 로그나 섞인 로그를 찾을 수 있음. */
+
+void sim_srand(uint32 seed);
+uint16 sim_rand(void);
+
+void sim_log_session(log_addr_t *apst_addr, uint16 sid, uint8 cnt, uint32 *p_time);
+int sim_log_verify(log_addr_t *apst_addr, uint16 head, uint16 tail, uint16 sid, uint8 cnt);
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef __HOST_SDK__
+#define __HOST_SDK__
+
+/* host_test 용 BLE SDK(OSAL/HAL) 대체 헤더
+ * 펌웨어 소스를 PC에서 그대로 컴파일하기 위해 사용하는 타입, SFR, HAL/OSAL 함수 선언만 가짐.
+ * SFR은 host_sdk.c의 변수, 플래시는 sim_flash.c의 RAM 배열로 대체됨. */
+
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef uint8 bool;
+typedef uint8 bStatus_t;
+typedef uint8 halIntState_t;
+
+#ifndef TRUE
+#define TRUE    1
+#endif
+#ifndef FALSE
+#define FALSE   0
+#endif
+#ifndef NULL
+#define NULL    ((void *)0)
+#endif
+#define VOID    (void)
+#define SUCCESS 0
+
+#define TASK_NO_TASK    0xFF
+
+#define BV(n)               (1 << (n))
+#define BUILD_UINT16(a, b)  ((uint16)((a) | ((b) << 8)))
+#define LO_UINT16(a)        ((a) & 0xFF)
+#define HI_UINT16(a)        (((a) >> 8) & 0xFF)
+
+#define HAL_ENTER_CRITICAL_SECTION(x)   ((x) = 0)
+#define HAL_EXIT_CRITICAL_SECTION(x)    ((void)(x))
+#define HAL_SYSTEM_RESET()
+#define HAL_ISR_FUNCTION(f, v)  void f(void)
+#define HAL_ENTER_ISR()
+#define HAL_EXIT_ISR()
+#define P0INT_VECTOR    0
+#define ADC_VECTOR      1
+
+/* SFR */
+extern volatile uint8 P0, P0_0, P0_2, P0_3, P0_4, P0_5, P0_7;
+extern volatile uint8 P1_0, P1_1, P1_2, P1_3, P1_4, P1_5, P1_6, P2_0;
+extern volatile uint8 P0SEL, P0INP, P0DIR, P1SEL, P1INP, P1DIR, P2SEL, P2DIR, P2INP;
+extern volatile uint8 P0IE, P0IEN, P0IFG, P0IF, PICTL, IEN1;
+extern volatile uint8 ADCCON1, ADCCON2, ADCCON3, ADCL, ADCH, ADCIF, ADCIE, APCFG;
+extern volatile uint8 MEMCTR, DMAREQ, T1CTL;
+
+/* flash
+ * HAL_FLASH_PAGE_MAP은 MEMCTR로 선택된 bank가 보이는 XDATA 창, host에서는 sim_flash의 배열 위치 */
+#define HAL_FLASH_WORD_SIZE     4
+#define HAL_FLASH_PAGE_SIZE     2048
+#define HAL_FLASH_PAGE_PER_BANK 16
+#define SIM_FLASH_PAGES         128
+extern uint8 sim_flash[SIM_FLASH_PAGES][HAL_FLASH_PAGE_SIZE];
+#define HAL_FLASH_PAGE_MAP      ((uintptr_t)sim_flash + (MEMCTR & 0x07) * 32768UL)
+
+void HalFlashRead(uint8 pg, uint16 offset, uint8 *buf, uint16 cnt);
+void HalFlashWrite(uint16 addr, uint8 *buf, uint16 cnt);
+void HalFlashErase(uint8 pg);
+
+/* adc */
+#define HAL_ADC_CHANNEL_0       0
+#define HAL_ADC_CHANNEL_6       6
+#define HAL_ADC_RESOLUTION_14   3
+#define HAL_ADC_REF_125V        0
+uint16 HalAdcRead(uint8 channel, uint8 resolution);
+void HalAdcSetReference(uint8 reference);
+
+/* i2c */
+#define i2cClock_33KHZ  0
+void HalI2CInit(uint8 clock);
+uint8 HalI2CRead(uint8 addr, uint8 len, uint8 *buf);
+uint8 HalI2CWrite(uint8 addr, uint8 len, uint8 *buf);
+
+/* OSAL */
+void *osal_mem_alloc(uint16 size);
+void osal_mem_free(void *ptr);
+void *osal_memset(void *dst, uint8 value, int len);
+void *osal_memcpy(void *dst, const void *src, unsigned int len);
+uint8 osal_memcmp(const void *src1, const void *src2, unsigned int len);
+uint8 osal_set_event(uint8 task_id, uint16 event_flag);
+uint8 osal_start_timerEx(uint8 task_id, uint16 event_id, uint32 timeout);
+uint8 osal_start_reload_timer(uint8 task_id, uint16 event_id, uint32 timeout);
+uint8 osal_stop_timerEx(uint8 task_id, uint16 event_id);
+uint32 osal_get_timeoutEx(uint8 task_id, uint16 event_id);
+uint32 osal_GetSystemClock(void);
+
+#endif